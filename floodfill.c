@@ -1,1331 +1,8349 @@
-/*******************************************************************************************
-*
-* Bitplane floodfill demos rendered with Raylib.
-*
-********************************************************************************************/
-
-#include "raylib.h"
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-#include <intrin.h>
-
-#include "profileapi.h"
-
-#define DARKDARKBLUE   CLITERAL(Color){ 0, 71, 141, 255 } 
-
-typedef unsigned char uint8;
-typedef unsigned short uint16;
-typedef unsigned int uint32; 
-typedef unsigned long long uint64;
-  
-
-uint64 CPUFreq = 0;
-uint64 OSFreq = 0;
-
-static inline uint64 ReadTSC()
-{
-    return __rdtsc();
-}
-
-static inline double CyclesToSeconds(uint64 cpuCycles)
-{
-    return (double)cpuCycles / (double)CPUFreq;
-}
-
-void InitializeTSCFrequency()
-{
-    LARGE_INTEGER counterFreq;
-    QueryPerformanceFrequency(&counterFreq);
-    
-    OSFreq = counterFreq.QuadPart;
-    
-    LARGE_INTEGER startCount, curCount;
-    QueryPerformanceCounter(&startCount);
-    curCount = startCount;
- 
-    uint64 tscStart = ReadTSC();
- 
-    // Spin for 50 ms. We know this will be 50ms because QPC frequency is always 10MHz.
-    uint64 calibrationInterval = OSFreq / 20;
-    while (curCount.QuadPart - startCount.QuadPart < calibrationInterval)
-    {
-        QueryPerformanceCounter(&curCount);
-    }
-    
-    uint64 osInterval = curCount.QuadPart - startCount.QuadPart;
-    uint64 tscInterval = ReadTSC() - tscStart;
-    CPUFreq = (tscInterval*OSFreq) / osInterval;
-    
-    printf("Detected timer frequencies: OS: %lld  CPU: %lld\n", OSFreq, CPUFreq);
-}
-
-
-  
-typedef struct 
-{
-    int RowIndex;
-    int Stage;
-    uint64 FillRowPrev;
-    uint64 Test;
-    bool PushNextAbove;
-    bool PushNextBelow;
-} SimulSpanFillSIState;
-
-typedef struct
-{
-    int CellIndex;
-    int Stage;
-    uint8 PushTop : 1;
-    uint8 PushBottom : 1;
-    uint8 PushLeft : 1;
-    uint8 PushRight : 1;
-} DFSSIState;
-
-typedef struct
-{
-    int CellIndex;
-    int Stage;
-    int X;
-    int xRight;
-    int xLeft;
-    int PrevSeed;
-    int PushCount;
-} SpanFillSIState;
-
-typedef union
-{
-    DFSSIState Dfs;
-    SpanFillSIState Sf;
-    SimulSpanFillSIState Ssf;
-} IncrementalState;
-  
-// Simultaneous span fill algorithm is specific to 64x64 plane. 
-// Planes of 128x128 or 256x256 could be handled in the same fashion with SSE and AVX respectively.
-// Larger planes can be handled by segmentation with, extra cases for horizontal span edges.
-// Planes of non-aligned sizes can be further handled by introducing intermediate copying for the working rows.
-// All of this would add general cost and complexity.
-
-// The algorithm can extend to 3D fills trivially by applying 4-way DFS in two dimensions, but we can do even
-// better by fitting entire decks of bits in SSE registers and doing fill operations on whole decks at once.
-
-const int dim = 64;
-const size_t decksize = (dim*dim)/8;
-const int numAlgos = 3;
-
-// Switched on algo
-int Flood(int algo, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
-int Flood_Incremental(int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
-int Flood_Incremental_Start(int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
-
-// DFS with stack
-int Flood_1(const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
-int Flood_1_Incremental(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
-int Flood_1_Incremental_Start(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
-
-// Span fill
-int Flood_2(const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
-int Flood_2_Incremental(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
-int Flood_2_Incremental_Start(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
-
-// Simultaneous Span fill 64 bit
-int Flood_3(const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
-int Flood_3_Incremental(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
-int Flood_3_Incremental_Start(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
-
-static int* SFI_Stack = 0;
-static int SFI_StackCount = 0;
-
-void SFI_StackInit(int dim)
-{
-    SFI_Stack = malloc(dim*sizeof(int));
-}
-
-void SFI_StackFree()
-{
-    free(SFI_Stack);
-}
-
-void SFI_StackPush(int index)
-{
-    SFI_Stack[SFI_StackCount++] = index;
-}
-
-int SFI_StackPop()
-{
-    return SFI_Stack[--SFI_StackCount];
-}
-
-int SFI_StackSize()
-{
-    return SFI_StackCount;
-}
-
-uint64 CountBits(uint64 val)
-{
-    return __popcnt64(val);
-}
-
-size_t Max(size_t a, size_t b)
-{
-    return a >= b ? a : b;
-}
-
-const char* AlgoName(int algoIndex)
-{
-    switch(algoIndex)
-    {
-        case 0: return "Four-Way DFS";
-        case 1: return "Span Fill";
-        case 2: return "Simul Span Fill";
-        default: return "";
-    }
-}
-
-void ResetDeck(uint8* deck)
-{
-    memset(deck, 0, decksize);
-}
-
-void FillDeck(uint8* deck)
-{
-    memset(deck, 0xff, decksize);
-}
-
-void SaveDeck(uint8* deck, const char* file)
-{
-    FILE* fh = fopen(file, "wb");
-    if (!fh) return;
-    
-    fwrite(deck, decksize, 1, fh);
-    fclose(fh);
-}
-
-void LoadDeck(uint8* deck, const char* file)
-{
-    FILE* fh = fopen(file, "rb");
-    if (!fh) return;
-    
-    fread(deck, decksize, 1, fh);
-    fclose(fh);
-}
-
-void FillWorstCase(uint8* deck)
-{
-     // This is an approximate worst case for scan fill
-    uint64* ull = (uint64*)deck;
-    // b01010101 
-    // b01110111 77
-    // b01010101
-    // b11011101 dd
-    ull[0] = 0x5555555555555555llu;
-    ull[1] = 0x7777777777777777llu;
-    ull[2] = 0x5555555555555555llu;
-    ull[3] = 0xddddddddddddddddllu;
-    ull[4] = 0x5555555555555555llu;
-    ull[5] = 0x7777777777777777llu;
-    ull[6] = 0x5555555555555555llu;
-    ull[7] = 0xddddddddddddddddllu;
-    ull[8] = 0x5555555555555555llu;
-    ull[9] = 0x7777777777777777llu;
-    ull[10] = 0x5555555555555555llu;
-    ull[11] = 0xddddddddddddddddllu;
-    ull[12] = 0x5555555555555555llu;
-    ull[13] = 0x7777777777777777llu;
-    ull[14] = 0x5555555555555555llu;
-    ull[15] = 0xddddddddddddddddllu;
-    ull[16] = 0x5555555555555555llu;
-    ull[17] = 0x7777777777777777llu;
-    ull[18] = 0x5555555555555555llu;
-    ull[19] = 0xddddddddddddddddllu;
-    ull[20] = 0x5555555555555555llu;
-    ull[21] = 0x7777777777777777llu;
-    ull[22] = 0x5555555555555555llu;
-    ull[23] = 0xddddddddddddddddllu;
-    ull[24] = 0x5555555555555555llu;
-    ull[25] = 0x7777777777777777llu;
-    ull[26] = 0x5555555555555555llu;
-    ull[27] = 0xddddddddddddddddllu;
-    ull[28] = 0x5555555555555555llu;
-    ull[29] = 0x7777777777777777llu;
-    ull[30] = 0x5555555555555555llu;
-    ull[31] = 0xddddddddddddddddllu;
-    ull[32] = 0x5555555555555555llu;
-    ull[33] = 0x7777777777777777llu;
-    ull[34] = 0x5555555555555555llu;
-    ull[35] = 0xddddddddddddddddllu;
-    ull[36] = 0x5555555555555555llu;
-    ull[37] = 0x7777777777777777llu;
-    ull[38] = 0x5555555555555555llu;
-    ull[39] = 0xddddddddddddddddllu;
-    ull[40] = 0x5555555555555555llu;
-    ull[41] = 0x7777777777777777llu;
-    ull[42] = 0x5555555555555555llu;
-    ull[43] = 0xddddddddddddddddllu;
-    ull[44] = 0x5555555555555555llu;
-    ull[45] = 0x7777777777777777llu;
-    ull[46] = 0x5555555555555555llu;
-    ull[47] = 0xddddddddddddddddllu;
-    ull[48] = 0x5555555555555555llu;
-    ull[49] = 0x7777777777777777llu;
-    ull[50] = 0x5555555555555555llu;
-    ull[51] = 0xddddddddddddddddllu;
-    ull[52] = 0x5555555555555555llu;
-    ull[53] = 0x7777777777777777llu;
-    ull[54] = 0x5555555555555555llu;
-    ull[55] = 0xddddddddddddddddllu;
-    ull[56] = 0x5555555555555555llu;
-    ull[57] = 0x7777777777777777llu;
-    ull[58] = 0x5555555555555555llu;
-    ull[59] = 0xddddddddddddddddllu;
-    ull[60] = 0x5555555555555555llu;
-    ull[61] = 0x7777777777777777llu;
-    ull[62] = 0x5555555555555555llu;
-    ull[63] = 0xddddddddddddddddllu;
-}
-
-//------------------------------------------------------------------------------------
-// Program main entry point
-//------------------------------------------------------------------------------------
-int main(void)
-{
-    // Initialization
-    //--------------------------------------------------------------------------------------
-    const int rectSize = 15;
-    const int rectMargin = 1;
-    const int rectSpacing = rectSize+rectMargin;
-    const int topMargin = 30;
-    
-    const int screenWidth = rectSpacing*dim + rectMargin;
-    const int screenHeight = rectSpacing*dim + rectMargin + topMargin;
-    
-    InitializeTSCFrequency();
-
-    InitWindow(screenWidth, screenHeight, "Bitplane Floodfill Tests");
-
-    SetTargetFPS(60);               // Set our game to run at 60 frames-per-second
-    //--------------------------------------------------------------------------------------
-
-
-
-    // 16x16 deck of bits
-
-    uint8* bitdeck = malloc(decksize);
-    uint8* filled = malloc(decksize);
-    uint8* visited = malloc(decksize);
-    uint8* tested = malloc(decksize);
-    
-    // Initial config 
-    FillDeck(bitdeck);
-    ResetDeck(filled);
-    ResetDeck(visited);
-    ResetDeck(tested);
-    
-    
-    unsigned int algoIndex = 0;
-    bool stepMode = false;
-    int iterationsPerFrame = 1;
-    
-    char textBuf[1024];
-    int lastFilledCount = 0;
-    
-    // Just as big as possibly required.
-    int* incrementalFillStack = malloc(sizeof(IncrementalState)*dim*dim);
-    int incrementalFillStackCount = 0;
-    
-    SFI_StackInit(dim);
-    
-    int maxStackSize = 0;
-    int totalTested = 0;
-
-    double lastRuntimeUS = 0.0f;
-
-    // Main game loop
-    while (!WindowShouldClose())    // Detect window close button or ESC key
-    {
-        // Update
-        
-        Vector2 mouseScreenPos = GetMousePosition();
-        int cellX = ((int)mouseScreenPos.x / rectSpacing);
-        int cellY = ((int)mouseScreenPos.y-topMargin) / rectSpacing;
-            
-        if (IsKeyPressed(KEY_S))
-        {
-            stepMode = !stepMode;
-        }            
-        
-        if (IsKeyPressed(KEY_KP_ADD))
-        {
-            iterationsPerFrame++;
-        }
-        if (IsKeyPressed(KEY_KP_SUBTRACT))
-        {
-            iterationsPerFrame = Max(1, iterationsPerFrame-1);
-        }
-            
-        if (incrementalFillStackCount > 0)
-        {
-            if (IsKeyPressed(KEY_ENTER))
-            {
-                ResetDeck(tested);
-                
-                while (incrementalFillStackCount)
-                {
-                    int testCount = 0;
-                    lastFilledCount +=  Flood_Incremental(algoIndex, bitdeck, dim, filled, incrementalFillStack, &incrementalFillStackCount, tested, &testCount);
-                    
-                    maxStackSize = incrementalFillStackCount > maxStackSize ? incrementalFillStackCount : maxStackSize;
-                    totalTested += testCount;
-                }
-                
-                ResetDeck(tested);
-            }
-            else if (!stepMode || IsKeyPressed(KEY_SPACE) || IsKeyPressedRepeat(KEY_SPACE))
-            {
-                ResetDeck(tested);
-                      
-                int remainingIterations = iterationsPerFrame;
-                while (remainingIterations && incrementalFillStackCount)
-                {
-                    int testCount = 0;
-                    lastFilledCount +=  Flood_Incremental(algoIndex, bitdeck, dim, filled, incrementalFillStack, &incrementalFillStackCount, tested, &testCount);
-                    
-                    maxStackSize = incrementalFillStackCount > maxStackSize ? incrementalFillStackCount : maxStackSize;
-                    totalTested += testCount;
-                    
-                    --remainingIterations;
-                }
-            }
-        }
-        else
-        {
-            ResetDeck(tested);
-            
-            if (IsKeyPressed(KEY_SPACE) || IsMouseButtonPressed(MOUSE_BUTTON_RIGHT))
-            {
-                ResetDeck(filled);
-            }
-            
-            if (IsKeyPressed(KEY_GRAVE))
-            {
-                FillDeck(bitdeck);
-            }
-            
-            if (IsKeyPressed(KEY_W))
-            {
-                FillWorstCase(bitdeck);
-            }
-            
-            if (IsKeyPressed(KEY_L))
-            {
-                LoadDeck(bitdeck, "saved.bitplane");
-            }
-            
-            if (IsKeyPressed(KEY_F))
-            {
-                SaveDeck(bitdeck, "saved.bitplane");
-            }
-            
-            if (IsKeyPressed(KEY_DOWN))
-            {
-                algoIndex = (algoIndex + 1) % numAlgos;
-            }
-            else if (IsKeyPressed(KEY_UP))
-            {
-                algoIndex = (algoIndex + numAlgos - 1) % numAlgos;
-            }
-            
-            if (IsMouseButtonDown(MOUSE_BUTTON_LEFT))
-            {
-                int bitIndex = cellY*dim + cellX;
-                int byte = bitIndex/8;
-                int bit = bitIndex%8;
-                if (IsKeyDown(KEY_LEFT_SHIFT))
-                {
-                   bitdeck[byte] = bitdeck[byte] | (1 << bit);
-                    
-                }
-                else
-                {
-                   bitdeck[byte] = bitdeck[byte] & ~(1 << bit);
-                }
-            }
-            
-            if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE))
-            {
-                maxStackSize = 0;
-                totalTested = 0;
-                
-                 if (IsKeyDown(KEY_LEFT_SHIFT))
-                 {
-                    lastFilledCount = Flood_Incremental_Start(algoIndex, bitdeck, dim, filled, incrementalFillStack, &incrementalFillStackCount, cellX, cellY);
-                 }
-                 else
-                 {
-                    uint64 startCycles = ReadTSC();
-                     
-                    lastFilledCount = Flood(algoIndex, bitdeck, dim, filled, cellX, cellY);
-                    
-                    uint64 interval = ReadTSC() - startCycles;
-                    lastRuntimeUS = CyclesToSeconds(interval)*1000000;
-                 }
-            }
-        }
-        
-
-
-        // Draw
-        //----------------------------------------------------------------------------------
-        BeginDrawing();
-
-            ClearBackground(RAYWHITE);
-            
-            sprintf(textBuf, "Screen pos: (%04d,%04d)  Last filled count: %d  Stack size: %d  Max stack size: %d Total reads: %d Last time: %.3fus", 
-                (int)mouseScreenPos.x, 
-                (int)mouseScreenPos.y, 
-                lastFilledCount, 
-                incrementalFillStackCount, 
-                maxStackSize, 
-                totalTested,
-                lastRuntimeUS);
-                
-            DrawText(textBuf, 0, 0, 12, BLACK);
-            
-            sprintf(textBuf, "Algo name: %s  Step mode: %s  Speed: %d", AlgoName(algoIndex), stepMode ? "on" : "off", iterationsPerFrame);
-            
-            DrawText(textBuf, 0, 14, 12, BLACK);
-            
-           for (int y = 0; y < dim; ++y)
-           {
-                for (int x = 0; x < dim; ++x)
-                {
-                    int index = y*dim + x;
-                    int byte = index/8;
-                    int bit = index%8;
-                    bool value = (bitdeck[byte] & (1 << bit)) != 0;
-                    bool isfilled = (filled[byte] & (1 << bit)) != 0;
-                    bool isTested = (tested[byte] & (1 << bit)) != 0;
-                    
-                    if (value)
-                    {
-                        DrawRectangle(
-                            x*rectSpacing + rectMargin, 
-                            y*rectSpacing + rectMargin + topMargin, 
-                            rectSize, 
-                            rectSize, 
-                            isTested ? YELLOW : (isfilled ? RED:DARKDARKBLUE));
-                    }
-                    else
-                    {
-                        DrawRectangleLines(
-                            x*rectSpacing + rectMargin, 
-                            y*rectSpacing + rectMargin + topMargin, 
-                            rectSize, 
-                            rectSize, 
-                            DARKDARKBLUE);
-                    }
-                }
-           }
-
-        EndDrawing();
-        //----------------------------------------------------------------------------------
-    }
-
-    // De-Initialization
-    //--------------------------------------------------------------------------------------
-    CloseWindow();        // Close window and OpenGL context
-    //--------------------------------------------------------------------------------------
-
-    return 0;
-}
-
-
-int Flood(int algo, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
-{
-    switch (algo)
-    {
-        case 0: return Flood_1(bitdeck, dim, filled, seedX, seedY);
-        case 1: return Flood_2(bitdeck, dim, filled, seedX, seedY);
-        case 2: return Flood_3(bitdeck, dim, filled, seedX, seedY);
-        default: return 0;
-    }
-}
-
-int Flood_Incremental(int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
-{
-    switch (algo)
-    {
-        case 0: return Flood_1_Incremental(bitdeck, dim, filled, stack, stackCount, tested, numTested);
-        case 1: return Flood_2_Incremental(bitdeck, dim, filled, stack, stackCount, tested, numTested);
-        case 2: return Flood_3_Incremental(bitdeck, dim, filled, stack, stackCount, tested, numTested);
-        default: return 0;
-    }
-}
-
-int Flood_Incremental_Start(int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
-{
-     switch (algo)
-    {
-        case 0: return Flood_1_Incremental_Start(bitdeck, dim, filled, stack, stackCount, seedX, seedY);
-        case 1: return Flood_2_Incremental_Start(bitdeck, dim, filled, stack, stackCount, seedX, seedY);
-        case 2: return Flood_3_Incremental_Start(bitdeck, dim, filled, stack, stackCount, seedX, seedY);
-        default: return 0;
-    }
-}
-
-// 4 directional test with stack
-
-static inline int FillCell(const uint8* bitdeck, int dim, uint8* filled, int x, int y)
-{
-    // bitwise intentional to collapse to single branch
-    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
-    
-    int cell = y*dim + x;
-    int byte = cell >> 3;
-    uint8 bitmask = 1 << (cell&7);
-    if (((bitdeck[byte] & bitmask) != 0) &&
-        ((filled[byte] & bitmask) == 0))
-    {
-        filled[byte] |= bitmask;
-        return cell;
-    }
-    return -1;
-}
-
-static inline int FillCellTest(const uint8* bitdeck, int dim, uint8* filled, uint8* tested, int* testCount, int x, int y)
-{
-    // bitwise intentional to collapse to single branch
-    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
-    
-    int cell = y*dim + x;
-    int byte = cell >> 3;
-    uint8 bitmask = 1 << (cell&7);
-    tested[byte] |= bitmask;
-    (*testCount)++;
-    
-    if (((bitdeck[byte] & bitmask) != 0) &&
-        ((filled[byte] & bitmask) == 0))
-    {
-        filled[byte] |= bitmask;
-        return cell;
-    }
-    return -1;
-}
-
-int Flood_1(const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
-{
-    int* stack = alloca(sizeof(int)*dim*dim); // Overkill for now
-    int stackCount = 0;
-    
-    // fill seed cell push on stack
-    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
-    if (cellIndex >= 0)
-    {
-        stack[stackCount++] = cellIndex;
-    }
-    
-    int totalFilled = 0;
-    
-    // while something in stack
-    while (stackCount)
-    {
-        ++totalFilled;
-        
-        // pop stack,
-        cellIndex = stack[--stackCount];
-        
-        // for each of 4 directions, if bitdeck positive and not filled, fill cell, push on stack
-        seedY = cellIndex/dim;
-        seedX = cellIndex%dim;
-        
-        int left = FillCell(bitdeck, dim, filled, seedX, seedY-1);
-        int right = FillCell(bitdeck, dim, filled, seedX, seedY+1);
-        int up = FillCell(bitdeck, dim, filled, seedX-1, seedY);
-        int down = FillCell(bitdeck, dim, filled, seedX+1, seedY);
-        
-        if (left >= 0) stack[stackCount++] = left;
-        if (right >= 0) stack[stackCount++] = right;
-        if (up >= 0) stack[stackCount++] = up;
-        if (down >= 0) stack[stackCount++] = down;
-    }
-    
-    return totalFilled;
-}
-
-int Flood_1_Incremental_Start(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
-{
-    IncrementalState* isStack = (IncrementalState*)stack;
-    
-    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
-    if (cellIndex >= 0)
-    {
-        IncrementalState newState;
-        memset(&newState, 0, sizeof(newState));
-        newState.Dfs.CellIndex = cellIndex;
-       
-        isStack[(*stackCount)++] = newState;
-        return *stackCount;
-    }
-    return 0;
-    
-}
-
-int Flood_1_Incremental(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
-{
-     // while something in stack
-    IncrementalState* isStack = (IncrementalState*)stack;
-    int sc = *stackCount;
-    int filledCount = 0;
-    int tc = 0;
-    
-    if (sc)
-    {
-        DFSSIState* state = &isStack[sc-1].Dfs;
-        
-        int cellIndex = state->CellIndex;
-        
-        // for each of 4 directions, if bitdeck positive and not filled, fill cell, push on stack
-        int y = cellIndex/dim;
-        int x = cellIndex%dim;
-        
-        switch (state->Stage)
-        {        
-        case 0:
-        {
-            int top = FillCellTest(bitdeck, dim, filled, tested, &tc, x, y-1);
-            if (top >= 0)
-            {
-                filledCount++;
-                state->PushTop = true;
-            }
-            state->Stage++;
-            break;
-        }
-        case 1:
-        {
-            int bottom = FillCellTest(bitdeck, dim, filled, tested, &tc, x, y+1);
-            if (bottom >= 0)
-            {
-                filledCount++;
-                state->PushBottom = true;
-            }
-            state->Stage++;
-            break;
-        }
-        case 2:
-        {
-            int left = FillCellTest(bitdeck, dim, filled, tested, &tc, x-1, y);
-            if (left >= 0)
-            {
-                filledCount++;
-                state->PushLeft = true;
-            }
-            state->Stage++;
-            break;
-        }
-        case 3:
-        {
-            int right = FillCellTest(bitdeck, dim, filled, tested, &tc, x+1, y);
-            if (right >= 0)
-            {
-                filledCount++;
-                state->PushRight = true;
-            }
-            state->Stage++;
-           // Fallthrough
-        }
-        case 4:
-        {
-            DFSSIState oldState = *state;
-            
-            // Pop stack
-            --sc;
-            
-            IncrementalState newState;
-            memset(&newState, 0, sizeof(newState));
-         
-            if (oldState.PushTop)
-            {
-                newState.Dfs.CellIndex = (y-1)*dim + x;
-                isStack[sc++] = newState;
-            }
-            if (oldState.PushBottom)
-            {
-                newState.Dfs.CellIndex = (y+1)*dim + x;
-                isStack[sc++] = newState;
-            }
-            if (oldState.PushLeft)
-            {
-                newState.Dfs.CellIndex = y*dim + x-1;
-                isStack[sc++] = newState;
-            }
-            if (oldState.PushRight)
-            {
-                newState.Dfs.CellIndex = y*dim + x+1;
-                isStack[sc++] = newState;
-            }
-           
-        }
-        default:
-            break;
-        };
-
-      
-        *stackCount = sc;
-    }
-   
-   *numTested = tc;
-   return filledCount;
-}
-
-static inline int TestCell(const uint8* bitdeck, int dim, uint8* filled, int x, int y)
-{
-    // bitwise intentional to collapse to single branch
-    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
-    
-    int cell = y*dim + x;
-    int byte = cell >> 3;
-    uint8 bitmask = 1 << (cell&7);
-    if (((bitdeck[byte] & bitmask) != 0) &&
-        ((filled[byte] & bitmask) == 0))
-    {
-        return cell;
-    }
-    return -1;
-}
-
-static inline int TestCellTest(const uint8* bitdeck, int dim, uint8* filled, uint8* tested, int* testCount, int x, int y)
-{
-    // bitwise intentional to collapse to single branch
-    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
-    
-    int cell = y*dim + x;
-    int byte = cell >> 3;
-    uint8 bitmask = 1 << (cell&7);
-    
-    tested[byte] |= bitmask;
-    (*testCount)++;
-    
-    if (((bitdeck[byte] & bitmask) != 0) &&
-        ((filled[byte] & bitmask) == 0))
-    {
-        return cell;
-    }
-    return -1;
-}
-
-int Flood_2(const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
-{
-    int* stack = alloca(sizeof(int)*dim*dim); // This algo very stack efficient except in pathological worst case where up to dim*dim/2 could be required.
-    int stackCount = 0;
-    
-    // Test and add seed cell to stack
-    int cellIndex = seedY*dim + seedX;
-    int byte = cellIndex >> 3;
-    int bitmask = (1 << (cellIndex&7));
-    
-    if ((bitdeck[byte] & bitmask) != 0 &&
-        (filled[byte] & bitmask) == 0)
-    {
-        stack[stackCount++] = cellIndex;
-    }
-    
-    int numfilled = 0;
-    
-    // While something on stack
-    while(stackCount)
-    {    
-        // pop cell index, 
-        cellIndex = stack[--stackCount];
-        
-        int xleft, xright;
-        
-        // Span fill right
-        int inc = 1;
-        int y = cellIndex/dim;
-        int x = cellIndex%dim;
-       
-        while (0 <= FillCell(bitdeck, dim, filled, x, y))
-        {
-            x+=inc;
-            ++numfilled;
-        }
-        xright = x-inc;
-       
-        // span fill left
-        x = (cellIndex%dim)-1;
-        inc = -1;
-        while (0 <= FillCell(bitdeck, dim, filled, x, y))
-        {
-            x+=inc;
-             ++numfilled;
-        }
-        xleft = x-inc;
-        
-        // Scan above for seed, push
-        if (y > 0)
-        {
-            x = xleft;
-            int prevSeed = -1;
-            while (x <= xright)
-            {
-                int newSeed = TestCell(bitdeck, dim, filled, x, y-1);
-                if (newSeed >= 0 && prevSeed == -1)
-                {
-                    stack[stackCount++] = newSeed;
-                }
-                prevSeed = newSeed;
-                ++x;
-            }
-        }
-        
-        // Scan below for seed, push
-        if (y < dim-1)
-        {
-            x = xleft;
-            int prevSeed = -1;
-            while (x <= xright)
-            {
-                int newSeed = TestCell(bitdeck, dim, filled, x, y+1);
-                if (newSeed >= 0 && prevSeed == -1)
-                {
-                    stack[stackCount++] = newSeed;
-                }
-                prevSeed = newSeed;
-                ++x;
-            }
-        }
-    }
-    
-    return numfilled;
-}
-
-int Flood_2_Incremental_Start(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
-{
-    IncrementalState* isStack = (IncrementalState*)stack;
-    
-    // Test and add seed cell to stack
-    int cellIndex = seedY*dim + seedX;
-    int byte = cellIndex >> 3;
-    int bitmask = (1 << (cellIndex&7));
-    
-    if ((bitdeck[byte] & bitmask) != 0 &&
-        (filled[byte] & bitmask) == 0)
-    {
-        IncrementalState newState;
-        memset(&newState, 0, sizeof(newState));
-        newState.Sf.CellIndex = cellIndex;
-        
-        isStack[(*stackCount)++] = newState;
-    }
-    
-    return 0;
-}
-
-int Flood_2_Incremental(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
-{
-    IncrementalState* isStack = (IncrementalState*)stack;
-    int numfilled = 0;
-    int tc = 0;
-    
-     // While something on stack
-    int sc = *stackCount;
-    if (sc)
-    {    
-        // pop cell index, 
-        SpanFillSIState* state = &isStack[sc-1].Sf;
-        int cellIndex = state->CellIndex;
-        int y = cellIndex/dim;
-        
-        switch (state->Stage)
-        {
-        case 0:
-        {
-            // Initialize
-            state->X = cellIndex%dim;
-            state->Stage++;
-            // fallthrough
-        }
-        case 1:
-        {
-            // Span fill right
-            int inc = 1;
-            if (0 <= FillCellTest(bitdeck, dim, filled, tested, &tc, state->X, y))
-            {
-                state->X+=inc;
-                ++numfilled;
-            }
-            else
-            {
-                state->xRight = state->X - inc;
-                state->X = (cellIndex%dim)-1;
-                state->Stage++;
-            }
-            break;
-        }
-        case 2:
-        {
-            // span fill left
-            int inc = -1;
-            if (0 <= FillCellTest(bitdeck, dim, filled, tested, &tc, state->X, y))
-            {
-                state->X+=inc;
-                 ++numfilled;
-            }
-            else
-            {
-                state->xLeft = state->X - inc;
-                state->X = state->xLeft;
-                state->PrevSeed = -1;
-                state->Stage++;
-            }
-            break;
-        }
-        case 3:
-        {
-            // Scan above for seed, push
-            if (y > 0)
-            {
-                if (state->X <= state->xRight)
-                {
-                    int newSeed = TestCellTest(bitdeck, dim, filled, tested, &tc, state->X, y-1);
-                    if (newSeed >= 0 && state->PrevSeed == -1)
-                    {
-                        SFI_StackPush(newSeed);
-                        state->PushCount++;
-                    }
-                    state->PrevSeed = newSeed;
-                    state->X++;
-                    break;
-                }
-               
-            }
-            
-            state->X = state->xLeft;
-            state->PrevSeed = -1;
-            state->Stage++;
-            // fallthrough;
-            
-        }
-        case 4:
-        {
-            // Scan below for seed, push
-            if (y < dim-1)
-            {
-                if (state->X <= state->xRight)
-                {
-                    int newSeed = TestCellTest(bitdeck, dim, filled, tested, &tc, state->X, y+1);
-                    if (newSeed >= 0 && state->PrevSeed == -1)
-                    {
-                        SFI_StackPush(newSeed);
-                        state->PushCount++;
-                    }
-                    state->PrevSeed = newSeed;
-                    state->X++;
-                    break;
-                }
-            }
-            state->Stage++;
-            // fallthrough
-        }
-        case 5:
-        {
-            // Resolve stack
-            int pushCount = state->PushCount;
-             --sc;
-            while (pushCount)
-            {
-                IncrementalState newState;
-                memset(&newState, 0, sizeof(newState));
-                
-                newState.Sf.CellIndex = SFI_StackPop();
-                isStack[sc++] = newState;
-                
-                --pushCount;
-            }
-            
-        }
-        
-        };
-    }
-    
-    *numTested = tc;
-    *stackCount = sc;
-    return numfilled;
-}
-
-
-int Flood_3(const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
-{
-    // This algorithm is optimized for grids of 64 bits per line, but wider lines can be accomodated
-    // by treating the overall grid as a grid of lines and adding cases for the horizontal neighbor tests.
-    
-    // Since we do full row operations, we cannot stack multiple discovered spans from the same row. We'll
-    // stack an entire row, and there are only two directions we can look for new work in, up and down.
-    // We'll prefer the down direction, so the stack size increases only when there is newly discovered
-    // work in the upward direction that we leave behind as we push downward. Therefore, we can't possibly
-    // push more than 'dim' rows to the stack, as that would imply we pushed more than one row per row
-    // we traversed. In fact, since we must scan at least two cells horizontally to discover a new vertical
-    // span, as we traverse the entire grid, we can't have pushed more than dim/2 rows to the stack, where
-    // dim is the longest dimension. I've generated this test case in the provided worst-case fill pattern,
-    // which will cause this algorithm to stack exactly 32 entries for a 64x64 grid if the fill is started
-    // from either top corner.
-    
-    int* stack = alloca(sizeof(int)*((dim+1)/2)); 
-    int stackCount = 0;
-    int numFilled = 0;
-    
-    // Test and add seed cell to stack    
-    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
-    if (cellIndex >= 0)
-    {
-        // We stack row numbers, not cell numbers
-        stack[stackCount++] = cellIndex/64;
-        ++numFilled;
-    }
-    
-    uint64* bitRows = (uint64*)bitdeck;
-    uint64* fillRows = (uint64*)filled;
-    while (stackCount)
-    {
-        int rowIndex = stack[--stackCount];
-        
-        uint64 bitRow = bitRows[rowIndex];
-        uint64 fillRow = fillRows[rowIndex];
-        uint64 fillRowStart = fillRow;
-        uint64 test = (fillRow<<1)&bitRow;
-        uint64 fillRowPrev = 0;
-        
-        // Simulscan fill left
-        while (test && (fillRowPrev != fillRow))
-        {
-            fillRowPrev = fillRow;
-            fillRow |= test;
-            test <<= 1;
-            test &= bitRow;
-        }
-        
-        // Simulscan fill right
-        fillRowPrev = 0;
-        test = (fillRow>>1)&bitRow;
-        while (test && (fillRowPrev != fillRow))
-        {
-            fillRowPrev = fillRow;
-            fillRow |= test;
-            test >>= 1;
-            test &= bitRow;
-        }
-        
-        fillRows[rowIndex] = fillRow;
-        numFilled += CountBits(fillRow ^ fillRowStart);
-        
-        // Bitfill up
-        if (rowIndex > 0)
-        {
-            uint64 oldFill = fillRows[rowIndex-1];
-            uint64 newFill = oldFill | (fillRow & bitRows[rowIndex-1]);
-            if (oldFill != newFill)
-            {
-                fillRows[rowIndex-1] = newFill;
-                stack[stackCount++] = rowIndex-1;
-                numFilled += CountBits(oldFill ^ newFill);
-            }
-        }
-        
-        // Bitfill down
-        if (rowIndex < dim-1)
-        {
-            uint64 oldFill = fillRows[rowIndex+1];
-            uint64 newFill = oldFill | (fillRow & bitRows[rowIndex+1]);
-            if (oldFill != newFill)
-            {
-                fillRows[rowIndex+1] = newFill;
-                stack[stackCount++] = rowIndex+1;
-                numFilled += CountBits(oldFill ^ newFill);
-            }
-        }
-    }
-    
-    return numFilled;
-}
-
-
-int Flood_3_Incremental_Start(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
-{
-     // Fill seed cell and stack its row
-     SimulSpanFillSIState* siStack = (SimulSpanFillSIState*)stack;
-     
-    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
-    if (cellIndex >= 0)
-    {
-        // We stack row numbers, not cell numbers
-        SimulSpanFillSIState newState;
-        memset(&newState, 0, sizeof(newState));
-        
-        newState.RowIndex = cellIndex/64;
-        
-        siStack[(*stackCount)++] = newState;
-        return 1;
-    }
-    
-    return 0;
-}
-
-
-int Flood_3_Incremental(const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
-{
-    IncrementalState* siStack = (IncrementalState*)stack;
-    uint64* bitRows = (uint64*)bitdeck;
-    uint64* fillRows = (uint64*)filled;
-    uint64* testRows = (uint64*)tested;
-    
-    int sc = *stackCount;
-    int numFilled = 0;
-    int testCount = 0;
-    
-    if (sc)
-    {
-        SimulSpanFillSIState* state = &siStack[sc-1].Ssf;
-        int rowIndex = state->RowIndex;
-        
-        uint64 bitRow = bitRows[rowIndex];
-        uint64 fillRow = fillRows[rowIndex];
-            
-        switch (state->Stage)
-        {
-            case 0:
-            {
-                state->FillRowPrev = 0;
-                state->Test = (fillRow<<1)&bitRow;
-                testCount++;
-                
-                state->Stage++;
-                // Fallthrough
-            }
-            case 1:
-            {                
-                // Simulscan fill left
-                if (state->Test)
-                {
-                    uint64 fillRowPrev = fillRow;
-                    fillRow |= state->Test;
-                    state->Test <<= 1;
-                    state->Test &= bitRow;
-                    
-                    if (fillRowPrev != fillRow)
-                    {
-                        fillRows[rowIndex] = fillRow;
-                        
-                        uint64 newFilled = fillRow ^ fillRowPrev;
-                        testRows[rowIndex] = newFilled;
-                        numFilled += CountBits(newFilled);
-                        break;
-                    }
-                }
-                
-                state->FillRowPrev = 0;
-                state->Test = (fillRow>>1)&bitRow;
-                
-                state->Stage++;
-                // Fallthrough
-            }
-            case 2:
-            {
-                // Simulscan fill right
-                if (state->Test)
-                {
-                    uint64 fillRowPrev = fillRow;
-                    fillRow |= state->Test;
-                    state->Test >>= 1;
-                    state->Test &= bitRow;
-                    if (fillRowPrev != fillRow)
-                    {
-                        fillRows[rowIndex] = fillRow;
-                        
-                        uint64 newFilled = fillRow ^ fillRowPrev;
-                        testRows[rowIndex] = newFilled;
-                        numFilled += CountBits(newFilled);
-                        break;
-                    }
-                }
-                state->Stage++;
-                // Fallthrough
-            }
-            case 3:
-            {     
-                // Bitfill up
-                if (rowIndex > 0)
-                {
-                    testCount++;
-                    testRows[rowIndex-1] |= fillRow;
-                    
-                    uint64 oldFill = fillRows[rowIndex-1];
-                    uint64 newFill = oldFill | (fillRow & bitRows[rowIndex-1]);
-                    if (oldFill != newFill)
-                    {
-                        fillRows[rowIndex-1] = newFill;
-                        state->PushNextAbove = true;
-                        
-                        // Count how many we filled
-                        numFilled += CountBits(oldFill ^ newFill);
-                        state->Stage++;
-                        break;
-                    }
-
-                }
-                state->Stage++;
-                // Fallthrough
-            }
-            case 4:
-            {
-            
-                // Bitfill down
-                if (rowIndex < dim-1)
-                {
-                    testCount++;
-                    testRows[rowIndex+1] |= fillRow;
-                    
-                    uint64 oldFill = fillRows[rowIndex+1];
-                    uint64 newFill = oldFill | (fillRow & bitRows[rowIndex+1]);
-                    if (oldFill != newFill)
-                    {
-                        fillRows[rowIndex+1] = newFill;
-                        state->PushNextBelow = true;
-                        
-                         // Count how many we filled
-                        numFilled += CountBits(oldFill ^ newFill);
-                    }
-                }
-                
-                // Pop existing state, push new ones on
-                
-                // Can't read existing state after decrement and push of a new state.
-                // Cache what we need.
-                bool pushNextAbove = state->PushNextAbove;
-                bool pushNextBelow = state->PushNextBelow;
-                --sc;
-                
-                IncrementalState newState;
-                memset(&newState, 0, sizeof(newState));
-                if (pushNextAbove)
-                {
-                    newState.Ssf.RowIndex = rowIndex-1;
-                    siStack[sc++] = newState;
-                }
-                if (pushNextBelow)
-                {
-                    newState.Ssf.RowIndex = rowIndex+1;
-                    siStack[sc++] = newState;
-                }
-            }
-            default:
-                break;  
-        }
-    }
-    
-    *numTested = testCount;
-    *stackCount = sc;
-    
-    return numFilled;
-}
-
+/*******************************************************************************************
+*
+* Bitplane floodfill demos rendered with Raylib.
+*
+* Define FLOODFILL_BENCHMARK to build the headless benchmark instead, which needs no raylib.
+*
+********************************************************************************************/
+
+#ifndef FLOODFILL_BENCHMARK
+#include "raylib.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <intrin.h>
+#include "profileapi.h"
+#include "synchapi.h"
+#include "processthreadsapi.h"
+#include "handleapi.h"
+#include "sysinfoapi.h"
+#include "fileapi.h"
+#include "memoryapi.h"
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Kernels using instruction sets past the x86-64 baseline are compiled for their target individually
+// and only called after checking the CPU supports them. Kernel bodies are force inlined into a wrapper
+// per target, so the same source compiles once per tier and CountBits becomes a popcnt where allowed.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FORCE_INLINE __forceinline
+#define TARGET_BMI2
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#define TARGET_BMI2 __attribute__((target("popcnt,lzcnt,bmi,bmi2")))
+#define TARGET_AVX2 __attribute__((target("avx2,popcnt,lzcnt,bmi,bmi2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx2,popcnt,lzcnt,bmi,bmi2")))
+#endif
+
+#define DARKDARKBLUE   CLITERAL(Color){ 0, 71, 141, 255 } 
+
+typedef unsigned char uint8;
+typedef unsigned short uint16;
+typedef unsigned int uint32; 
+typedef unsigned long long uint64;
+typedef long long int64;
+  
+
+uint64 CPUFreq = 0;
+uint64 OSFreq = 0;
+
+static inline uint64 ReadTSC()
+{
+    return __rdtsc();
+}
+
+static inline double CyclesToSeconds(uint64 cpuCycles)
+{
+    return (double)cpuCycles / (double)CPUFreq;
+}
+
+#ifdef _WIN32
+static inline uint64 ReadOSTimer()
+{
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    return count.QuadPart;
+}
+
+static inline uint64 ReadOSTimerFreq()
+{
+    LARGE_INTEGER counterFreq;
+    QueryPerformanceFrequency(&counterFreq);
+    return counterFreq.QuadPart;
+}
+#else
+static inline uint64 ReadOSTimer()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec*1000000000llu + (uint64)ts.tv_nsec;
+}
+
+static inline uint64 ReadOSTimerFreq()
+{
+    // clock_gettime reports nanoseconds
+    return 1000000000llu;
+}
+#endif
+
+void InitializeTSCFrequency()
+{
+    OSFreq = ReadOSTimerFreq();
+    
+    uint64 startCount = ReadOSTimer();
+    uint64 curCount = startCount;
+ 
+    uint64 tscStart = ReadTSC();
+ 
+    // Spin for 50 ms of OS timer ticks.
+    uint64 calibrationInterval = OSFreq / 20;
+    while (curCount - startCount < calibrationInterval)
+    {
+        curCount = ReadOSTimer();
+    }
+    
+    uint64 osInterval = curCount - startCount;
+    uint64 tscInterval = ReadTSC() - tscStart;
+    CPUFreq = (uint64)(((double)tscInterval*(double)OSFreq) / (double)osInterval);
+    
+    printf("Detected timer frequencies: OS: %lld  CPU: %lld\n", OSFreq, CPUFreq);
+}
+
+
+  
+typedef struct 
+{
+    int RowIndex;
+    int Stage;
+    uint64 FillRowPrev;
+    uint64 Test;
+    bool PushNextAbove;
+    bool PushNextBelow;
+} SimulSpanFillSIState;
+
+typedef struct
+{
+    int CellIndex;
+    int Stage;
+    uint8 PushTop : 1;
+    uint8 PushBottom : 1;
+    uint8 PushLeft : 1;
+    uint8 PushRight : 1;
+    uint8 PushTopLeft : 1;
+    uint8 PushTopRight : 1;
+    uint8 PushBottomLeft : 1;
+    uint8 PushBottomRight : 1;
+} DFSSIState;
+
+typedef struct
+{
+    int CellIndex;
+    int Stage;
+    int X;
+    int xRight;
+    int xLeft;
+    int PrevSeed;
+    int PushCount;
+} SpanFillSIState;
+
+typedef union
+{
+    DFSSIState Dfs;
+    SpanFillSIState Sf;
+    SimulSpanFillSIState Ssf;
+} IncrementalState;
+
+// Scratch owned by the caller and reused across fills. Buffers grow to the largest bound an algorithm
+// has asked for and are never shrunk, so once warmed up a fill does no allocation at all. Nothing in
+// here is shared between contexts, so fills on separate contexts can run on separate threads. Growing
+// the scratch aborts the process when memory runs out, fills never fail for want of it.
+typedef struct
+{
+    int Connectivity;           // 4 or 8 neighbours per cell, FloodContextInit sets 4
+    int* Stack;                 // Cell or row stack, sized to the algorithm's bound
+    size_t StackCapacity;
+    uint64* RowFlags;           // One bit per row, marks rows already waiting on the stack
+    size_t RowFlagsCapacity;
+    uint64* Rows;               // Word padded copies of bitdeck and filled for unaligned dims
+    size_t RowsCapacity;
+    int* SeedStack;             // Seeds found by one step of Flood_2_Incremental
+    size_t SeedStackCapacity;
+    int SeedStackCount;
+    int* Labels;                // Region id per cell, valid for cells filled by the current batch
+    size_t LabelsCapacity;
+    uint8* LabeledCells;        // Cells of the current batch that already have a label
+    size_t LabeledCellsCapacity;
+    struct RowRun* Runs;        // Row runs of the deck being labelled
+    size_t RunsCapacity;
+    struct FloodTile* Tiles;    // Per tile seeds and state of a tiled fill
+    size_t TilesCapacity;
+    int* TileQueues;            // One ring of tile indices per pool worker
+    size_t TileQueuesCapacity;
+    uint64* Reached;            // Words reached by a step of a distance fill, all clear between fills
+    size_t ReachedCapacity;
+} FloodContext;
+
+typedef struct
+{
+    int X;
+    int Y;
+} FloodSeed;
+
+typedef struct
+{
+    int MaxCells;               // Most cells the region may have, 0 for no limit
+    bool UseBox;                // Region must stay inside MinX..MaxX, MinY..MaxY inclusive
+    int MinX;
+    int MinY;
+    int MaxX;
+    int MaxY;
+} FloodLimits;
+
+typedef struct
+{
+    uint64 Area;
+    int MinX;                   // Bounding box, inclusive, MinX > MaxX when nothing was filled
+    int MinY;
+    int MaxX;
+    int MaxY;
+    uint64 SumX;                // The centroid is (SumX, SumY)/Area
+    uint64 SumY;
+    uint64 SumXX;               // Second moments about the origin, central ones are SumXX/Area - cx*cx etc.
+    uint64 SumYY;
+    uint64 SumXY;
+} FloodStats;
+
+typedef struct
+{
+    int X;
+    int Y;
+    bool Set;                   // True opens the cell, false blocks it
+} FloodEdit;
+
+// One fill of a batch run by FloodJobsRun. Workers claim jobs about this many bytes of decks at a time.
+#define FLOOD_JOB_CHUNK_BYTES (64*1024)
+
+typedef struct
+{
+    const uint8* Bitdeck;
+    int Dim;
+    uint8* Filled;
+    int SeedX;
+    int SeedY;
+    int NumFilled;              // Set when the job has run
+} FloodJob;
+
+#ifdef _WIN32
+typedef void* FloodThread;
+typedef SRWLOCK FloodMutex;
+typedef CONDITION_VARIABLE FloodCond;
+#else
+typedef pthread_t FloodThread;
+typedef pthread_mutex_t FloodMutex;
+typedef pthread_cond_t FloodCond;
+#endif
+
+typedef struct FloodPoolWorker
+{
+    struct FloodPool* Pool;
+    int Index;
+    FloodThread Thread;
+} FloodPoolWorker;
+
+// Worker threads parked between jobs. The thread calling FloodPoolRun works as worker 0, so a pool of
+// one worker starts no threads at all.
+typedef struct FloodPool
+{
+    int NumWorkers;
+    FloodPoolWorker* Workers;
+    FloodContext* Contexts;     // Scratch of each worker for FloodJobsRun
+    FloodMutex RunLock;         // One job at a time
+    FloodMutex Lock;
+    FloodCond WakeCond;
+    FloodCond DoneCond;
+    void (*Job)(void* arg, int worker);
+    void* JobArg;
+    int JobGeneration;
+    int WorkersBusy;
+    bool Quit;
+} FloodPool;
+
+// Region of every open cell of a plane, kept up to date under edits. Owns a copy of the plane, so the
+// caller's deck isn't needed once it's built.
+typedef struct
+{
+    int Dim;
+    int Connectivity;
+    uint64* BitRows;            // Word padded copy of the plane
+    size_t BitRowsCapacity;
+    struct RowRun* Runs;        // Union-find over the row runs, including runs edits took out of their row
+    size_t RunsCapacity;
+    int NumRuns;
+    int NumDeadRuns;            // Runs no longer in any row, which only hold the trees together
+    struct RowBand* Bands;      // Rows a root's region may span, one per run
+    size_t BandsCapacity;
+    int* RowRuns;               // Live runs of each row in x order, MaxRowRuns slots per row
+    size_t RowRunsCapacity;
+    int* RowRunCounts;
+    size_t RowRunCountsCapacity;
+    int MaxRowRuns;
+    int* Members;               // Runs of a region being rebuilt
+    size_t MembersCapacity;
+} FloodIndex;
+
+// Plane file header. Raw files are followed at DataOffset by Height rows of RowStride bytes each. Rows
+// are whole 64 bit words, bit x of a row being bit x%64 of word x/64, with the bits past Width clear, so
+// a mapped row is the same as a row of the word padded decks the fills work on. Compressed files hold
+// the same rows encoded one after another from DataOffset, and can only be loaded, not mapped.
+#define FLOOD_PLANE_MAGIC 0x4e4c5042u     // "BPLN"
+#define FLOOD_PLANE_VERSION_RAW 1
+#define FLOOD_PLANE_VERSION_COMPRESSED 2
+
+typedef struct
+{
+    uint32 Magic;
+    uint32 Version;
+    uint64 Width;
+    uint64 Height;
+    uint64 RowStride;           // Bytes per row, a multiple of 8
+    uint64 DataOffset;          // File offset of row 0, a multiple of 8
+} FloodPlaneHeader;
+
+// An open plane file. Rows are reached through views of the file mapping, never read into buffers.
+typedef struct
+{
+#ifdef _WIN32
+    void* File;
+    void* Mapping;
+#else
+    int File;
+#endif
+    bool Writable;
+    FloodPlaneHeader Header;
+} FloodPlaneFile;
+
+typedef struct
+{
+    void* Base;
+    size_t Length;
+} FloodPlaneView;
+
+typedef enum
+{
+    FloodBlock_Empty,
+    FloodBlock_Full,
+    FloodBlock_Mixed,
+} FloodBlockState;
+
+// Open cell count of every 64x64 block of a plane, so fills can take whole blocks at once
+typedef struct
+{
+    int Dim;
+    int BlocksAcross;
+    uint16* Counts;             // Row major, a block of dim % 64 cells on an edge is full at fewer than 4096
+    size_t CountsCapacity;
+} FloodSummary;
+
+// numWorkers 0 uses one worker per hardware thread
+void FloodPoolInit(FloodPool* pool, int numWorkers);
+void FloodPoolFree(FloodPool* pool);
+// Runs job(arg, worker) on every worker of the pool and returns once they have all returned
+void FloodPoolRun(FloodPool* pool, void (*job)(void* arg, int worker), void* arg);
+
+// Runs every job with Flood_Dispatch on the workers of the pool, each fill using its worker's own
+// context, so jobs share no scratch and the contexts stay warm across batches. Workers claim jobs a
+// chunk of about FLOOD_JOB_CHUNK_BYTES of decks at a time. done (may be null) is called on the worker
+// that ran each job as soon as it's finished, and FloodJobsRun returns once every job has.
+void FloodJobsRun(FloodPool* pool, int connectivity, FloodJob* jobs, int numJobs, void (*done)(FloodJob* job, void* arg), void* doneArg);
+
+void FloodContextInit(FloodContext* ctx);
+void FloodContextFree(FloodContext* ctx);
+  
+// Simultaneous span fill algorithm is specific to 64x64 plane. 
+// Planes of 128x128 or 256x256 are handled in the same fashion with SSE and AVX2 respectively (Flood_5/6).
+// Larger planes can be handled by segmentation with, extra cases for horizontal span edges.
+// Planes of non-aligned sizes can be further handled by introducing intermediate copying for the working rows.
+// All of this would add general cost and complexity, so it lives in a separate algorithm (Flood_4) that
+// treats each row as a run of 64 bit words and leaves the 64x64 path untouched.
+
+// The algorithm can extend to 3D fills trivially by applying 4-way DFS in two dimensions, but we can do even
+// better by fitting entire decks of bits in SSE registers and doing fill operations on whole decks at once.
+// Flood_8 does the whole deck variant in 2D, with a 64x64 deck in eight AVX-512 registers.
+
+const int dim = 64;
+const size_t decksize = (dim*dim)/8;
+const int numAlgos = 10;
+
+// Switched on algo
+int Flood(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+int Flood_Incremental(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
+int Flood_Incremental_Start(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
+
+// Fills the region of every seed into 'filled' (cleared first) and writes one region id per seed, numbered
+// in the order the regions are first reached, -1 for blocked seeds. Returns the number of regions.
+int Flood_Batch(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, const FloodSeed* seeds, int numSeeds, int* regionIds);
+
+// Labels every connected region of the deck in one pass, with the context's connectivity. Labels are
+// numbered in raster order of each region's first cell, blocked cells get -1. areas (may be null)
+// receives the cell count per label and must hold (dim*dim+1)/2 entries. Returns the number of regions.
+int Flood_Label(FloodContext* ctx, const uint8* bitdeck, int dim, int* labels, int* areas);
+
+// True when (bx,by) is in the same region as (ax,ay). Both ends are grown a row at a time and the query
+// stops as soon as the two fills meet, or either one runs out, which is the answer when the cells are near
+// or one of them is in a small pocket. Needs no 'filled' deck, the fills live in the context.
+bool Flood_Reachable(FloodContext* ctx, const uint8* bitdeck, int dim, int ax, int ay, int bx, int by);
+
+// Flood_4 that gives up once the region is known to break a limit, e.g. more than MaxCells cells or a
+// cell outside the box. 'truncated' (may be null) says whether it gave up, in which case 'filled' holds a
+// partial region that may already run a row past the limit. Returns the number of newly filled cells.
+int Flood_Bounded(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, const FloodLimits* limits, bool* truncated);
+
+// The dispatched fill that also gathers the area, bounding box and moments of the cells it fills. The
+// fill notes the rows it changes as it goes and the stats are taken from those rows alone once it's
+// done, so there's no second pass over 'filled'. Returns the number of newly filled cells.
+int Flood_Stats(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, FloodStats* stats);
+
+// The same stats over every set cell of a deck, in one pass a word at a time
+void FloodStatsOfDeck(const uint8* deck, int dim, FloodStats* stats);
+
+// A fill of the context's connectivity grown breadth first a step at a time, for the step count from the
+// seed to every cell of its region. distances gets one entry per cell in raster order,
+// FLOOD_DISTANCE_UNREACHED for cells outside the region, and distances past 65534 are written as 65534.
+// Set cells of 'filled' count as blocked.
+// Returns the number of steps, one more than the greatest distance, 0 when the seed is blocked.
+#define FLOOD_DISTANCE_UNREACHED 0xffff
+int Flood_Distances(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint16* distances);
+// The same steps written as a deck of the cells first reached at each step, fronts holding maxFronts
+// decks of (dim*dim+7)/8 bytes back to back. Stops after maxFronts steps, 'filled' then holding the
+// cells up to that distance. Returns the number of fronts written.
+int Flood_Wavefronts(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint8* fronts, int maxFronts);
+
+// Writes the open cells that can't reach the border of the plane, with the context's connectivity, into
+// 'enclosed', in one fill seeded from the whole border. The deck with its holes filled is ~bitdeck |
+// enclosed. Returns the number of enclosed cells.
+int Flood_Enclosed(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* enclosed);
+
+// Fills through bitdeck & clip only, e.g. one zone of the plane, without building the combined deck.
+// clip is a deck the same size as bitdeck. This is the only mode that takes a clip, every other fill,
+// Flood_Dispatch and Flood_Tiled included, needs the combined deck. Returns the number of newly filled
+// cells.
+int Flood_Clipped(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY);
+
+// Applies cell edits to bitdeck and keeps 'filled' holding exactly the region of (seedX,seedY), as a fresh
+// fill of the edited deck would, by only touching the part of the fill each edit can change. Returns the
+// net change in the number of filled cells.
+int Flood_Update(FloodContext* ctx, uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, const FloodEdit* edits, int numEdits);
+
+// Persistent region index, for asking which region cells are in far more often than the plane changes.
+// Queries are a binary search over one row's runs and a union-find lookup. Edits that open cells only
+// join regions, edits that close cells rebuild the runs of the one region they may cut. Region ids are
+// only stable until the next edit, and queries compress paths, so one index isn't shared between threads.
+void FloodIndexInit(FloodIndex* index);
+void FloodIndexFree(FloodIndex* index);
+void FloodIndexBuild(FloodIndex* index, const uint8* bitdeck, int dim, int connectivity);
+void FloodIndexEdit(FloodIndex* index, const FloodEdit* edits, int numEdits);
+// Region id of a cell, -1 for blocked cells and cells off the plane
+int FloodIndexRegionOf(FloodIndex* index, int x, int y);
+bool FloodIndexSameRegion(FloodIndex* index, int ax, int ay, int bx, int by);
+
+// DFS with stack
+int Flood_1(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+int Flood_1_Incremental(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
+int Flood_1_Incremental_Start(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
+
+// Span fill
+int Flood_2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+int Flood_2_Incremental(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
+int Flood_2_Incremental_Start(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
+
+// Simultaneous Span fill 64 bit
+int Flood_3(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+int Flood_3_Incremental(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested);
+int Flood_3_Incremental_Start(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY);
+
+// Simultaneous Span fill, rows of any number of 64 bit words
+int Flood_4(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// Simultaneous Span fill 128 bit rows in SSE registers, other sizes use Flood_4
+int Flood_5(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// Simultaneous Span fill 256 bit rows in AVX2 registers, other sizes and older CPUs use Flood_4
+int Flood_6(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// Simultaneous Span fill 64 bit, spans expanded with carry propagation
+int Flood_7(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// Whole 64x64 deck held in AVX-512 registers and dilated to a fixpoint, Flood_7 on older CPUs
+int Flood_8(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// Span fill with span ends and seed runs found a word at a time, any dim
+int Flood_9(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// 64x64 tiles filled with the Flood_7 kernel by every worker of the pool, seeds passed between tiles at
+// their edges. Same result as the single threaded fills. Needs dim to be a multiple of 64, other dims
+// and a null pool use Flood_Dispatch. With a summary (may be null) of the same plane, seeds are never
+// passed into empty blocks, and a full block is filled whole without running the kernel. A summary
+// built for another dim is ignored.
+int Flood_Tiled(FloodContext* ctx, FloodPool* pool, const FloodSummary* summary, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+// Occupancy summary of a plane in 64x64 blocks. Build counts every block once, edits are applied to
+// bitdeck and adjust one count each, so the summary stays current for as long as the plane is only
+// edited through it.
+void FloodSummaryInit(FloodSummary* summary);
+void FloodSummaryFree(FloodSummary* summary);
+void FloodSummaryBuild(FloodSummary* summary, const uint8* bitdeck, int dim);
+void FloodSummaryEdit(FloodSummary* summary, uint8* bitdeck, const FloodEdit* edits, int numEdits);
+FloodBlockState FloodSummaryBlock(const FloodSummary* summary, int blockX, int blockY);
+
+// Plane files of any size, mapped rather than read. Create makes a zeroed plane, Open checks the header
+// against the file size. Both return false on failure.
+bool FloodPlaneCreate(FloodPlaneFile* plane, const char* path, int width, int height);
+bool FloodPlaneOpen(FloodPlaneFile* plane, const char* path, bool writable);
+void FloodPlaneClose(FloodPlaneFile* plane);
+// Maps rows firstRow.. of the plane, returns row firstRow or null on failure
+uint64* FloodPlaneMapRows(FloodPlaneFile* plane, int firstRow, int numRows, FloodPlaneView* view);
+void FloodPlaneUnmap(FloodPlaneView* view);
+// Writes rows of whole words, as many per row as a width bit row needs, to a plane file. Compressed
+// files store each row in as few bytes as its runs allow, raw ones can be mapped by FloodPlaneOpen.
+// Returns false on failure.
+bool FloodPlaneSave(const char* path, const uint64* rows, int width, int height, bool compress);
+// Reads a plane file of either kind into newly allocated rows of whole words, to be released with
+// free(). Returns null on failure.
+uint64* FloodPlaneLoad(const char* path, int* width, int* height);
+
+// Fills a plane file into a writable plane file of the same shape, mapping one band of rows of each at
+// a time so about maxResidentBytes of the planes are mapped at once, however large they are. Returns
+// the number of newly filled cells, -1 when the files don't match or can't be mapped.
+int64 Flood_Streamed(FloodContext* ctx, FloodPlaneFile* bits, FloodPlaneFile* filled, int seedX, int seedY, size_t maxResidentBytes);
+
+// Fills many 64x64 decks at once, one seed each, with the decks bit-sliced so every word op works on 64
+// of them (256 with AVX2, 512 with AVX-512). bitdecks and filled hold numDecks decks of decksize bytes
+// back to back. Each deck's fill is or'd into its 'filled', normally clear, whose set cells count as
+// blocked. Made for throughput over many decks: a group of decks costs as much as the slowest deck in
+// it. Returns the total number of newly filled cells.
+int64 Flood_Sliced(FloodContext* ctx, const uint8* bitdecks, uint8* filled, const FloodSeed* seeds, int numDecks);
+
+// Best kernel for the host CPU and plane size, resolved once from CPUID (FLOODFILL_TIER overrides, a
+// tier the host can't run is ignored). Safe to call from any thread, Flood_Dispatch calls it too.
+void InitializeFloodKernels();
+int Flood_Dispatch(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+void FloodContextInit(FloodContext* ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->Connectivity = 4;
+}
+
+void FloodContextFree(FloodContext* ctx)
+{
+    free(ctx->Stack);
+    free(ctx->RowFlags);
+    free(ctx->Rows);
+    free(ctx->SeedStack);
+    free(ctx->Labels);
+    free(ctx->LabeledCells);
+    free(ctx->Runs);
+    free(ctx->Tiles);
+    free(ctx->TileQueues);
+    free(ctx->Reached);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+// All ones when diagonal neighbours connect, for masking the sideways part of a row's reach
+static FORCE_INLINE uint64 FloodDiagonals(const FloodContext* ctx)
+{
+    return ctx->Connectivity == 8 ? ~0llu : 0;
+}
+
+// The cells of a neighbouring row a filled row reaches: straight up or down, plus one cell either side
+// when diagonals connect.
+static FORCE_INLINE uint64 ReachRow(uint64 fillRow, uint64 diagonals)
+{
+    return fillRow | (((fillRow << 1) | (fillRow >> 1)) & diagonals);
+}
+
+// Never returns null. Every fill writes through its scratch straight away and has no way to report a
+// failed grow, so running out of memory (or a size past size_t) aborts here, the one place it's handled.
+static void* FloodContextReserve(void** buffer, size_t* capacity, size_t count, size_t elementSize)
+{
+    if (count > *capacity)
+    {
+        void* grown = count <= (size_t)-1/elementSize ? realloc(*buffer, count*elementSize) : 0;
+        if (!grown) abort();
+        *buffer = grown;
+        *capacity = count;
+    }
+    return *buffer;
+}
+
+static int* FloodContextStack(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->Stack, &ctx->StackCapacity, count, sizeof(int));
+}
+
+static uint64* FloodContextRowFlags(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->RowFlags, &ctx->RowFlagsCapacity, count, sizeof(uint64));
+}
+
+static uint64* FloodContextRows(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->Rows, &ctx->RowsCapacity, count, sizeof(uint64));
+}
+
+static int* FloodContextSeedStack(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->SeedStack, &ctx->SeedStackCapacity, count, sizeof(int));
+}
+
+static int* FloodContextLabels(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->Labels, &ctx->LabelsCapacity, count, sizeof(int));
+}
+
+static uint8* FloodContextLabeledCells(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->LabeledCells, &ctx->LabeledCellsCapacity, count, sizeof(uint8));
+}
+
+// Only the grown part is cleared, the fills that use the plane clear the words they set before returning
+static uint64* FloodContextReached(FloodContext* ctx, size_t count)
+{
+    size_t cleared = ctx->ReachedCapacity;
+    uint64* reached = FloodContextReserve((void**)&ctx->Reached, &ctx->ReachedCapacity, count, sizeof(uint64));
+    if (count > cleared) memset(reached + cleared, 0, sizeof(uint64)*(count - cleared));
+    return reached;
+}
+
+static void Cpuid(uint32 leaf, uint32 subleaf, uint32 regs[4])
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    __cpuidex((int*)regs, leaf, subleaf);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64 ReadXCR0()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    uint32 eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64)edx << 32) | eax;
+#endif
+}
+
+typedef struct
+{
+    bool Detected;
+    bool Popcnt;
+    bool LZCNT;
+    bool BMI1;
+    bool BMI2;
+    bool AVX2;
+    bool AVX512F;
+} CpuFeatures;
+
+static CpuFeatures HostCpu;
+
+static const CpuFeatures* GetCpuFeatures()
+{
+    if (!HostCpu.Detected)
+    {
+        uint32 regs[4];
+        Cpuid(0, 0, regs);
+        uint32 maxLeaf = regs[0];
+        
+        Cpuid(1, 0, regs);
+        bool osxsave = (regs[2] & (1u << 27)) != 0;
+        bool avx = (regs[2] & (1u << 28)) != 0;
+        HostCpu.Popcnt = (regs[2] & (1u << 23)) != 0;
+        
+        // The OS has to be saving the register state as well as the CPU supporting the instructions.
+        // XCR0 bits 1-2 are the XMM/YMM state, bits 5-7 the opmask and ZMM state.
+        uint64 xcr0 = osxsave ? ReadXCR0() : 0;
+        bool ymmState = (xcr0 & 0x6) == 0x6;
+        bool zmmState = (xcr0 & 0xe6) == 0xe6;
+        
+        uint32 leaf7Ebx = 0;
+        if (maxLeaf >= 7)
+        {
+            Cpuid(7, 0, regs);
+            leaf7Ebx = regs[1];
+        }
+        
+        Cpuid(0x80000000, 0, regs);
+        if (regs[0] >= 0x80000001)
+        {
+            Cpuid(0x80000001, 0, regs);
+            HostCpu.LZCNT = (regs[2] & (1u << 5)) != 0;
+        }
+        
+        HostCpu.BMI1 = (leaf7Ebx & (1u << 3)) != 0;
+        HostCpu.BMI2 = (leaf7Ebx & (1u << 8)) != 0;
+        HostCpu.AVX2 = avx && ymmState && (leaf7Ebx & (1u << 5));
+        HostCpu.AVX512F = avx && zmmState && (leaf7Ebx & (1u << 16));
+        HostCpu.Detected = true;
+    }
+    return &HostCpu;
+}
+
+// Instruction set tiers the flood kernels are compiled for. Each tier includes the ones before it.
+typedef enum
+{
+    FloodTier_Scalar,   // x86-64 baseline, SSE2
+    FloodTier_BMI2,     // POPCNT, LZCNT, BMI1, BMI2
+    FloodTier_AVX2,
+    FloodTier_AVX512,   // AVX-512F
+    FloodTier_Count
+} FloodTier;
+
+const char* FloodTierName(FloodTier tier)
+{
+    switch (tier)
+    {
+        case FloodTier_Scalar: return "scalar";
+        case FloodTier_BMI2: return "bmi2";
+        case FloodTier_AVX2: return "avx2";
+        case FloodTier_AVX512: return "avx512";
+        default: return "";
+    }
+}
+
+bool CpuSupportsTier(FloodTier tier)
+{
+    const CpuFeatures* cpu = GetCpuFeatures();
+    bool bmi2 = cpu->Popcnt && cpu->LZCNT && cpu->BMI1 && cpu->BMI2;
+    switch (tier)
+    {
+        case FloodTier_Scalar: return true;
+        case FloodTier_BMI2: return bmi2;
+        case FloodTier_AVX2: return bmi2 && cpu->AVX2;
+        case FloodTier_AVX512: return bmi2 && cpu->AVX2 && cpu->AVX512F;
+        default: return false;
+    }
+}
+
+// Tier of the kernels InitializeFloodKernels picked, resolving them first if need be. Code with its own
+// tier wrappers picks them by this, so FLOODFILL_TIER forces every path down to the same tier.
+FloodTier FloodActiveTier();
+
+#if defined(_MSC_VER) && !defined(__clang__)
+static uint64 CountBitsSoftware(uint64 val)
+{
+    val = val - ((val >> 1) & 0x5555555555555555llu);
+    val = (val & 0x3333333333333333llu) + ((val >> 2) & 0x3333333333333333llu);
+    val = (val + (val >> 4)) & 0x0f0f0f0f0f0f0f0fllu;
+    return (val * 0x0101010101010101llu) >> 56;
+}
+#endif
+
+static FORCE_INLINE uint64 CountBits(uint64 val)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    // MSVC emits popcnt for __popcnt64 whatever the target, so it has to be checked at runtime.
+    return HostCpu.Popcnt ? __popcnt64(val) : CountBitsSoftware(val);
+#else
+    // A library call in baseline code, a single popcnt inside the tier wrappers.
+    return __builtin_popcountll(val);
+#endif
+}
+
+static FORCE_INLINE uint64 ReverseBits(uint64 val)
+{
+    val = ((val >> 1) & 0x5555555555555555llu) | ((val & 0x5555555555555555llu) << 1);
+    val = ((val >> 2) & 0x3333333333333333llu) | ((val & 0x3333333333333333llu) << 2);
+    val = ((val >> 4) & 0x0f0f0f0f0f0f0f0fllu) | ((val & 0x0f0f0f0f0f0f0f0fllu) << 4);
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _byteswap_uint64(val);
+#else
+    return __builtin_bswap64(val);
+#endif
+}
+
+// Index of the lowest set bit, val must be non-zero. tzcnt inside the BMI tier wrappers, bsf otherwise.
+static FORCE_INLINE int LowestBit(uint64 val)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, val);
+    return (int)index;
+#else
+    return __builtin_ctzll(val);
+#endif
+}
+
+// Index of the highest set bit, val must be non-zero. lzcnt inside the BMI tier wrappers, bsr otherwise.
+static FORCE_INLINE int HighestBit(uint64 val)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanReverse64(&index, val);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(val);
+#endif
+}
+
+size_t Max(size_t a, size_t b)
+{
+    return a >= b ? a : b;
+}
+
+const char* AlgoName(int algoIndex)
+{
+    switch(algoIndex)
+    {
+        case 0: return "Four-Way DFS";
+        case 1: return "Span Fill";
+        case 2: return "Simul Span Fill";
+        case 3: return "Multi-Word Simul Span Fill";
+        case 4: return "SSE 128 Simul Span Fill";
+        case 5: return "AVX2 256 Simul Span Fill";
+        case 6: return "Carry Simul Span Fill";
+        case 7: return "AVX-512 Register Deck Fill";
+        case 8: return "CPU Dispatched Fill";
+        case 9: return "Word Span Fill";
+        default: return "";
+    }
+}
+
+bool AlgoSupportsDim(int algoIndex, int dim)
+{
+    switch(algoIndex)
+    {
+        case 0: return true;
+        case 1: return true;
+        case 2: return dim == 64;
+        case 3: return true;
+        case 4: return dim == 128;
+        case 5: return dim == 256;
+        case 6: return dim == 64;
+        case 7: return dim == 64;
+        case 8: return true;
+        case 9: return true;
+        default: return false;
+    }
+}
+
+void ResetDeck(uint8* deck)
+{
+    memset(deck, 0, decksize);
+}
+
+void FillDeck(uint8* deck)
+{
+    memset(deck, 0xff, decksize);
+}
+
+// Saved as a compressed plane file. A 64 cell row of the deck is one word, so the deck is its own rows.
+void SaveDeck(uint8* deck, const char* file)
+{
+    FloodPlaneSave(file, (const uint64*)deck, dim, dim, true);
+}
+
+void LoadDeck(uint8* deck, const char* file)
+{
+    int width;
+    int height;
+    uint64* rows = FloodPlaneLoad(file, &width, &height);
+    if (rows)
+    {
+        if (width == dim && height == dim) memcpy(deck, rows, decksize);
+        free(rows);
+        return;
+    }
+    
+    // Files saved before the header are just the deck
+    FILE* fh = fopen(file, "rb");
+    if (!fh) return;
+    
+    // Read aside first so a short file leaves the deck as it was
+    uint32 magic;
+    if (fread(&magic, sizeof(magic), 1, fh) == 1 && magic != FLOOD_PLANE_MAGIC)
+    {
+        uint8* saved = malloc(decksize);
+        rewind(fh);
+        if (saved && fread(saved, decksize, 1, fh) == 1) memcpy(deck, saved, decksize);
+        free(saved);
+    }
+    fclose(fh);
+}
+
+void FillWorstCase(uint8* deck)
+{
+     // This is an approximate worst case for scan fill
+    uint64* ull = (uint64*)deck;
+    // b01010101 
+    // b01110111 77
+    // b01010101
+    // b11011101 dd
+    ull[0] = 0x5555555555555555llu;
+    ull[1] = 0x7777777777777777llu;
+    ull[2] = 0x5555555555555555llu;
+    ull[3] = 0xddddddddddddddddllu;
+    ull[4] = 0x5555555555555555llu;
+    ull[5] = 0x7777777777777777llu;
+    ull[6] = 0x5555555555555555llu;
+    ull[7] = 0xddddddddddddddddllu;
+    ull[8] = 0x5555555555555555llu;
+    ull[9] = 0x7777777777777777llu;
+    ull[10] = 0x5555555555555555llu;
+    ull[11] = 0xddddddddddddddddllu;
+    ull[12] = 0x5555555555555555llu;
+    ull[13] = 0x7777777777777777llu;
+    ull[14] = 0x5555555555555555llu;
+    ull[15] = 0xddddddddddddddddllu;
+    ull[16] = 0x5555555555555555llu;
+    ull[17] = 0x7777777777777777llu;
+    ull[18] = 0x5555555555555555llu;
+    ull[19] = 0xddddddddddddddddllu;
+    ull[20] = 0x5555555555555555llu;
+    ull[21] = 0x7777777777777777llu;
+    ull[22] = 0x5555555555555555llu;
+    ull[23] = 0xddddddddddddddddllu;
+    ull[24] = 0x5555555555555555llu;
+    ull[25] = 0x7777777777777777llu;
+    ull[26] = 0x5555555555555555llu;
+    ull[27] = 0xddddddddddddddddllu;
+    ull[28] = 0x5555555555555555llu;
+    ull[29] = 0x7777777777777777llu;
+    ull[30] = 0x5555555555555555llu;
+    ull[31] = 0xddddddddddddddddllu;
+    ull[32] = 0x5555555555555555llu;
+    ull[33] = 0x7777777777777777llu;
+    ull[34] = 0x5555555555555555llu;
+    ull[35] = 0xddddddddddddddddllu;
+    ull[36] = 0x5555555555555555llu;
+    ull[37] = 0x7777777777777777llu;
+    ull[38] = 0x5555555555555555llu;
+    ull[39] = 0xddddddddddddddddllu;
+    ull[40] = 0x5555555555555555llu;
+    ull[41] = 0x7777777777777777llu;
+    ull[42] = 0x5555555555555555llu;
+    ull[43] = 0xddddddddddddddddllu;
+    ull[44] = 0x5555555555555555llu;
+    ull[45] = 0x7777777777777777llu;
+    ull[46] = 0x5555555555555555llu;
+    ull[47] = 0xddddddddddddddddllu;
+    ull[48] = 0x5555555555555555llu;
+    ull[49] = 0x7777777777777777llu;
+    ull[50] = 0x5555555555555555llu;
+    ull[51] = 0xddddddddddddddddllu;
+    ull[52] = 0x5555555555555555llu;
+    ull[53] = 0x7777777777777777llu;
+    ull[54] = 0x5555555555555555llu;
+    ull[55] = 0xddddddddddddddddllu;
+    ull[56] = 0x5555555555555555llu;
+    ull[57] = 0x7777777777777777llu;
+    ull[58] = 0x5555555555555555llu;
+    ull[59] = 0xddddddddddddddddllu;
+    ull[60] = 0x5555555555555555llu;
+    ull[61] = 0x7777777777777777llu;
+    ull[62] = 0x5555555555555555llu;
+    ull[63] = 0xddddddddddddddddllu;
+}
+
+#ifdef FLOODFILL_BENCHMARK
+//------------------------------------------------------------------------------------
+// Headless benchmark entry point
+//------------------------------------------------------------------------------------
+// Built without raylib by defining FLOODFILL_BENCHMARK, e.g.
+//     gcc -O2 -DFLOODFILL_BENCHMARK floodfill.c -o floodbench
+// Every algorithm is run from every open cell of every deck in the corpus. Cycle counts per
+// fill are reported as min/median/p99, along with throughput in filled cells per nanosecond.
+// Each fill is checked against the Four-Way DFS result so a broken algorithm fails the run. Every
+// deck is run with 4-connectivity, then again with 8, where DFS follows diagonals too.
+//
+// Larger planes run from an evenly spaced subset of their open cells, so every deck costs roughly
+// the same to sweep.
+//
+// Usage: floodbench [-r repeats] [-s maxseeds] [file.bitplane ...]
+
+typedef struct
+{
+    char Name[64];
+    int Dim;
+    uint8* Bits;
+} BenchDeck;
+
+static uint64 BenchRandState = 0x2545f4914f6cdd1dllu;
+
+static uint64 BenchRand()
+{
+    // xorshift64*, fixed seed so every run sees the same corpus
+    BenchRandState ^= BenchRandState >> 12;
+    BenchRandState ^= BenchRandState << 25;
+    BenchRandState ^= BenchRandState >> 27;
+    return BenchRandState * 0x2545f4914f6cdd1dllu;
+}
+
+static inline size_t DeckBytes(int dim)
+{
+    return ((size_t)dim*dim + 7)/8;
+}
+
+static inline void SetCell(uint8* deck, int dim, int x, int y)
+{
+    int cell = y*dim + x;
+    deck[cell >> 3] |= 1 << (cell&7);
+}
+
+static inline bool GetCell(const uint8* deck, int dim, int x, int y)
+{
+    int cell = y*dim + x;
+    return (deck[cell >> 3] & (1 << (cell&7))) != 0;
+}
+
+void FillRandom(uint8* deck, int dim, int densityPercent)
+{
+    memset(deck, 0, DeckBytes(dim));
+    for (int y = 0; y < dim; ++y)
+    {
+        for (int x = 0; x < dim; ++x)
+        {
+            if ((int)(BenchRand() % 100) < densityPercent)
+            {
+                SetCell(deck, dim, x, y);
+            }
+        }
+    }
+}
+
+void FillMaze(uint8* deck, int dim)
+{
+    // Recursive backtracker over the odd cells, carving the wall cell between neighbours.
+    // Produces a single long winding corridor, which is the worst shape for row based fills.
+    memset(deck, 0, DeckBytes(dim));
+    
+    int cellsPerSide = (dim-1)/2;
+    if (cellsPerSide <= 0) return;
+    
+    int* stack = malloc(sizeof(int)*cellsPerSide*cellsPerSide);
+    int stackCount = 0;
+    
+    SetCell(deck, dim, 1, 1);
+    stack[stackCount++] = 0;
+    
+    while (stackCount)
+    {
+        int mazeCell = stack[stackCount-1];
+        int cx = mazeCell % cellsPerSide;
+        int cy = mazeCell / cellsPerSide;
+        
+        int options[4];
+        int numOptions = 0;
+        if (cx > 0 && !GetCell(deck, dim, 2*cx-1, 2*cy+1)) options[numOptions++] = mazeCell-1;
+        if (cx < cellsPerSide-1 && !GetCell(deck, dim, 2*cx+3, 2*cy+1)) options[numOptions++] = mazeCell+1;
+        if (cy > 0 && !GetCell(deck, dim, 2*cx+1, 2*cy-1)) options[numOptions++] = mazeCell-cellsPerSide;
+        if (cy < cellsPerSide-1 && !GetCell(deck, dim, 2*cx+1, 2*cy+3)) options[numOptions++] = mazeCell+cellsPerSide;
+        
+        if (numOptions == 0)
+        {
+            --stackCount;
+            continue;
+        }
+        
+        int next = options[BenchRand() % numOptions];
+        int nx = next % cellsPerSide;
+        int ny = next / cellsPerSide;
+        SetCell(deck, dim, cx + nx + 1, cy + ny + 1);
+        SetCell(deck, dim, 2*nx+1, 2*ny+1);
+        stack[stackCount++] = next;
+    }
+    
+    free(stack);
+}
+
+void FillSerpentine(uint8* deck, int dim)
+{
+    // Full width corridors joined by a single cell at alternating ends, so every row is entered
+    // through one cell and has to be span filled across its whole width.
+    memset(deck, 0, DeckBytes(dim));
+    for (int y = 0; y < dim; ++y)
+    {
+        if (y % 2 == 0)
+        {
+            for (int x = 0; x < dim; ++x)
+            {
+                SetCell(deck, dim, x, y);
+            }
+        }
+        else
+        {
+            SetCell(deck, dim, (y/2) % 2 ? 0 : dim-1, y);
+        }
+    }
+}
+
+void FillWorstCaseDim(uint8* deck, int dim)
+{
+    // FillWorstCase repeated out to any multiple of 8 wide
+    static const uint8 rowPattern[4] = { 0x55, 0x77, 0x55, 0xdd };
+    for (int y = 0; y < dim; ++y)
+    {
+        memset(deck + (size_t)y*dim/8, rowPattern[y%4], dim/8);
+    }
+}
+
+static int CompareUint64(const void* a, const void* b)
+{
+    uint64 va = *(const uint64*)a;
+    uint64 vb = *(const uint64*)b;
+    return (va > vb) - (va < vb);
+}
+
+static int CompareInt(const void* a, const void* b)
+{
+    int va = *(const int*)a;
+    int vb = *(const int*)b;
+    return (va > vb) - (va < vb);
+}
+
+static uint64 HashDeck(const uint8* deck, size_t size)
+{
+    // FNV-1a
+    uint64 hash = 0xcbf29ce484222325llu;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ deck[i]) * 0x100000001b3llu;
+    }
+    return hash;
+}
+
+static BenchDeck* AddBenchDeck(BenchDeck* decks, int* numDecks, const char* name, int dim)
+{
+    BenchDeck* deck = &decks[(*numDecks)++];
+    snprintf(deck->Name, sizeof(deck->Name), "%s", name);
+    deck->Dim = dim;
+    deck->Bits = calloc(DeckBytes(dim), 1);
+    return deck;
+}
+
+static uint64 SumCycles(const uint64* cycles, int numSamples)
+{
+    uint64 totalCycles = 0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        totalCycles += cycles[i];
+    }
+    return totalCycles;
+}
+
+static double CellsPerNS(uint64 numCells, uint64 totalCycles)
+{
+    double totalNS = CyclesToSeconds(totalCycles)*1000000000.0;
+    return totalNS > 0.0 ? (double)numCells / totalNS : 0.0;
+}
+
+// Sorts the samples and prints one row of the results table. Each sample times one fill, query or
+// file, or the average over a group of them, so the fills/ms column is numSamples over their sum;
+// numFills is only what the fills column shows. A null ctx and a negative cellsPerNS print as "-".
+static void PrintBenchRow(const FloodContext* ctx, const BenchDeck* deck, const char* name, uint64* cycles, int numSamples, int numFills, double cellsPerNS, bool mismatch)
+{
+    double totalMS = CyclesToSeconds(SumCycles(cycles, numSamples))*1000.0;
+    qsort(cycles, numSamples, sizeof(uint64), CompareUint64);
+    
+    char conn[8] = "-";
+    if (ctx) snprintf(conn, sizeof(conn), "%d", ctx->Connectivity);
+    char cells[16] = "-";
+    if (cellsPerNS >= 0.0) snprintf(cells, sizeof(cells), "%.3f", cellsPerNS);
+    
+    printf("%-16s %4d %4s  %-28s %8d %10llu %10llu %10llu %10s %10.1f%s\n",
+        deck->Name,
+        deck->Dim,
+        conn,
+        name,
+        numFills,
+        cycles[0],
+        cycles[numSamples/2],
+        cycles[((size_t)numSamples*99)/100],
+        cells,
+        totalMS > 0.0 ? numSamples / totalMS : 0.0,
+        mismatch ? "  MISMATCH" : "");
+}
+
+// Times the whole seed list as one Flood_Batch call and reports the cost per seed, against the cells
+// the same seeds fill one at a time. Seeds must share a region id exactly when their reference fills
+// are the same. Returns the number of seeds that got a wrong id.
+int BenchmarkBatch(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, const uint64* refHashes, const int* refCounts, int repeats)
+{
+    int dim = deck->Dim;
+    uint8* filled = malloc(DeckBytes(dim));
+    FloodSeed* batchSeeds = malloc(sizeof(FloodSeed)*numSeeds);
+    int* regionIds = malloc(sizeof(int)*numSeeds);
+    int* regionFirstSeed = malloc(sizeof(int)*numSeeds);
+    uint64* sortedHashes = malloc(sizeof(uint64)*numSeeds);
+    uint64* cycles = malloc(sizeof(uint64)*repeats);
+    
+    uint64 seedCells = 0;
+    for (int s = 0; s < numSeeds; ++s)
+    {
+        batchSeeds[s].X = seeds[s]%dim;
+        batchSeeds[s].Y = seeds[s]/dim;
+        seedCells += refCounts[s];
+    }
+    
+    int numRegions = 0;
+    uint64 totalCycles = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        uint64 startCycles = ReadTSC();
+        numRegions = Flood_Batch(ctx, 8, deck->Bits, dim, filled, batchSeeds, numSeeds, regionIds);
+        cycles[r] = ReadTSC() - startCycles;
+        totalCycles += cycles[r];
+    }
+    
+    // Each id has to map to one reference region, and there have to be as many ids as distinct regions
+    int wrongIds = 0;
+    for (int s = 0; s < numSeeds; ++s)
+    {
+        regionFirstSeed[s] = -1;
+    }
+    for (int s = 0; s < numSeeds; ++s)
+    {
+        int id = regionIds[s];
+        if (id < 0 || id >= numRegions)
+        {
+            ++wrongIds;
+        }
+        else if (regionFirstSeed[id] < 0)
+        {
+            regionFirstSeed[id] = s;
+        }
+        else if (refHashes[regionFirstSeed[id]] != refHashes[s])
+        {
+            ++wrongIds;
+        }
+    }
+    memcpy(sortedHashes, refHashes, sizeof(uint64)*numSeeds);
+    qsort(sortedHashes, numSeeds, sizeof(uint64), CompareUint64);
+    int distinctRegions = 0;
+    for (int s = 0; s < numSeeds; ++s)
+    {
+        distinctRegions += (s == 0 || sortedHashes[s] != sortedHashes[s-1]);
+    }
+    if (distinctRegions != numRegions)
+    {
+        ++wrongIds;
+    }
+    
+    for (int r = 0; r < repeats; ++r)
+    {
+        cycles[r] /= numSeeds;
+    }
+    PrintBenchRow(ctx, deck, "Batch Dispatched Fill", cycles, repeats, numSeeds*repeats, CellsPerNS(seedCells*repeats, totalCycles), wrongIds != 0);
+    
+    free(cycles);
+    free(sortedHashes);
+    free(regionFirstSeed);
+    free(regionIds);
+    free(batchSeeds);
+    free(filled);
+    
+    return wrongIds;
+}
+
+
+// Labels the whole deck with Flood_Label, and the old way as a batch with every cell as a seed, which
+// numbers regions in the same raster order. The two label maps must be identical.
+int BenchmarkLabel(FloodContext* ctx, const BenchDeck* deck, int repeats)
+{
+    int dim = deck->Dim;
+    int numCells = dim*dim;
+    uint8* filled = malloc(DeckBytes(dim));
+    FloodSeed* cellSeeds = malloc(sizeof(FloodSeed)*numCells);
+    int* batchLabels = malloc(sizeof(int)*numCells);
+    int* runLabels = malloc(sizeof(int)*numCells);
+    int* areas = malloc(sizeof(int)*((numCells + 1)/2));
+    uint64* cycles = malloc(sizeof(uint64)*repeats);
+    
+    uint64 setCells = 0;
+    for (int i = 0; i < numCells; ++i)
+    {
+        cellSeeds[i].X = i%dim;
+        cellSeeds[i].Y = i/dim;
+        setCells += GetCell(deck->Bits, dim, i%dim, i/dim);
+    }
+    
+    int batchRegions = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        uint64 startCycles = ReadTSC();
+        batchRegions = Flood_Batch(ctx, 8, deck->Bits, dim, filled, cellSeeds, numCells, batchLabels);
+        cycles[r] = ReadTSC() - startCycles;
+    }
+    PrintBenchRow(ctx, deck, "Label by Batch Fills", cycles, repeats, repeats, CellsPerNS(setCells*repeats, SumCycles(cycles, repeats)), false);
+    
+    int runRegions = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        uint64 startCycles = ReadTSC();
+        runRegions = Flood_Label(ctx, deck->Bits, dim, runLabels, areas);
+        cycles[r] = ReadTSC() - startCycles;
+    }
+    
+    uint64 areaTotal = 0;
+    for (int l = 0; l < runRegions; ++l)
+    {
+        areaTotal += areas[l];
+    }
+    int mismatch = runRegions != batchRegions || areaTotal != setCells || memcmp(runLabels, batchLabels, sizeof(int)*numCells) != 0;
+    PrintBenchRow(ctx, deck, "Label by Row Runs", cycles, repeats, repeats, CellsPerNS(setCells*repeats, SumCycles(cycles, repeats)), mismatch);
+    
+    free(cycles);
+    free(areas);
+    free(runLabels);
+    free(batchLabels);
+    free(cellSeeds);
+    free(filled);
+    
+    return mismatch;
+}
+
+// Finds the enclosed cells the old way, a dispatched fill from every border cell into one deck and the
+// open cells left over, then with Flood_Enclosed. Both must give the same cells.
+int BenchmarkEnclosed(FloodContext* ctx, const BenchDeck* deck, int repeats)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* filled = malloc(size);
+    uint8* refEnclosed = calloc(size, 1);
+    uint8* enclosed = calloc(size, 1);
+    uint64* cycles = malloc(sizeof(uint64)*repeats);
+    uint64 numCells = (uint64)dim*dim;
+    
+    for (int r = 0; r < repeats; ++r)
+    {
+        uint64 startCycles = ReadTSC();
+        memset(filled, 0, size);
+        for (int i = 0; i < dim; ++i)
+        {
+            Flood_Dispatch(ctx, deck->Bits, dim, filled, i, 0);
+            Flood_Dispatch(ctx, deck->Bits, dim, filled, i, dim-1);
+            Flood_Dispatch(ctx, deck->Bits, dim, filled, 0, i);
+            Flood_Dispatch(ctx, deck->Bits, dim, filled, dim-1, i);
+        }
+        for (size_t i = 0; i < size; ++i)
+        {
+            refEnclosed[i] = deck->Bits[i] & ~filled[i];
+        }
+        cycles[r] = ReadTSC() - startCycles;
+    }
+    PrintBenchRow(ctx, deck, "Enclosed by Border Fills", cycles, repeats, repeats, CellsPerNS(numCells*repeats, SumCycles(cycles, repeats)), false);
+    
+    int refCount = 0;
+    for (int i = 0; i < dim*dim; ++i)
+    {
+        refCount += GetCell(refEnclosed, dim, i%dim, i/dim);
+    }
+    
+    int numEnclosed = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        uint64 startCycles = ReadTSC();
+        numEnclosed = Flood_Enclosed(ctx, deck->Bits, dim, enclosed);
+        cycles[r] = ReadTSC() - startCycles;
+    }
+    int mismatch = numEnclosed != refCount || memcmp(enclosed, refEnclosed, size) != 0;
+    PrintBenchRow(ctx, deck, "Enclosed in One Pass", cycles, repeats, repeats, CellsPerNS(numCells*repeats, SumCycles(cycles, repeats)), mismatch);
+    
+    free(cycles);
+    free(enclosed);
+    free(refEnclosed);
+    free(filled);
+    
+    return mismatch;
+}
+
+// Asks whether each seed reaches the next one in the list, which is usually near it, first with a whole
+// dispatched fill and a bit test, then with Flood_Reachable, then from a prebuilt FloodIndex. Every
+// answer must agree.
+int BenchmarkReachable(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, int repeats)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* filled = malloc(size);
+    bool* answers = malloc(sizeof(bool)*numSeeds);
+    uint64* cycles = malloc(sizeof(uint64)*(size_t)numSeeds*repeats);
+    int mismatches = 0;
+    
+    FloodIndex index;
+    FloodIndexInit(&index);
+    FloodIndexBuild(&index, deck->Bits, dim, ctx->Connectivity);
+    
+    static const char* methodNames[3] = { "Fill Then Test", "Reachable Query", "Index Query" };
+    for (int method = 0; method < 3; ++method)
+    {
+        int numSamples = 0;
+        int methodMismatches = 0;
+        int numReachable = 0;
+        
+        for (int s = 0; s + 1 < numSeeds; ++s)
+        {
+            int ax = seeds[s]%dim;
+            int ay = seeds[s]/dim;
+            int bx = seeds[s+1]%dim;
+            int by = seeds[s+1]/dim;
+            bool reachable = false;
+            
+            for (int r = 0; r < repeats; ++r)
+            {
+                uint64 startCycles = ReadTSC();
+                if (method == 0)
+                {
+                    memset(filled, 0, size);
+                    Flood_Dispatch(ctx, deck->Bits, dim, filled, ax, ay);
+                    reachable = GetCell(filled, dim, bx, by);
+                }
+                else if (method == 1)
+                {
+                    reachable = Flood_Reachable(ctx, deck->Bits, dim, ax, ay, bx, by);
+                }
+                else
+                {
+                    reachable = FloodIndexSameRegion(&index, ax, ay, bx, by);
+                }
+                cycles[numSamples++] = ReadTSC() - startCycles;
+            }
+            
+            if (method == 0) answers[s] = reachable;
+            else if (answers[s] != reachable) ++methodMismatches;
+            numReachable += reachable;
+        }
+        
+        if (numSamples == 0) break;
+        
+        // Queries touch no fixed number of cells, so these rows only report the query rate
+        char name[64];
+        snprintf(name, sizeof(name), "%s, %d/%d", methodNames[method], numReachable, numSeeds - 1);
+        PrintBenchRow(ctx, deck, name, cycles, numSamples, numSamples, -1.0, methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    FloodIndexFree(&index);
+    free(cycles);
+    free(answers);
+    free(filled);
+    
+    return mismatches;
+}
+
+// True when the index puts cells in the same region exactly when Flood_Label does
+static bool IndexMatchesLabels(FloodIndex* index, const int* labels, int numLabels, int dim, int* labelRegions)
+{
+    memset(labelRegions, 0xff, sizeof(int)*Max(numLabels, 1));
+    for (int i = 0; i < dim*dim; ++i)
+    {
+        int region = FloodIndexRegionOf(index, i%dim, i/dim);
+        if ((region < 0) != (labels[i] < 0)) return false;
+        if (region < 0) continue;
+        
+        if (labelRegions[labels[i]] < 0) labelRegions[labels[i]] = region;
+        else if (labelRegions[labels[i]] != region) return false;
+    }
+    
+    // Labels map onto regions, and no two labels may share one
+    qsort(labelRegions, numLabels, sizeof(int), CompareInt);
+    for (int l = 1; l < numLabels; ++l)
+    {
+        if (labelRegions[l] == labelRegions[l-1]) return false;
+    }
+    return true;
+}
+
+// Builds a FloodIndex of the deck, then edits a copy of the deck a random cell toggle at a time through
+// the index. After every edit the index must split the plane into the same regions as Flood_Label.
+// Cells/ns is the plane size over the build or edit time.
+int BenchmarkIndex(FloodContext* ctx, const BenchDeck* deck, int repeats)
+{
+    const int numEdits = 256;
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* bits = malloc(size);
+    FloodEdit* edits = malloc(sizeof(FloodEdit)*numEdits);
+    int* labels = malloc(sizeof(int)*dim*dim);
+    int* labelRegions = malloc(sizeof(int)*((dim*dim + 1)/2 + 1));
+    uint64* cycles = malloc(sizeof(uint64)*(size_t)numEdits*repeats);
+    int mismatches = 0;
+    
+    memcpy(bits, deck->Bits, size);
+    for (int e = 0; e < numEdits; ++e)
+    {
+        int x = (int)(BenchRand() % dim);
+        int y = (int)(BenchRand() % dim);
+        edits[e].X = x;
+        edits[e].Y = y;
+        edits[e].Set = !GetCell(bits, dim, x, y);
+        bits[((size_t)y*dim + x) >> 3] ^= 1 << ((y*dim + x) & 7);
+    }
+    
+    FloodIndex index;
+    FloodIndexInit(&index);
+    
+    for (int method = 0; method < 2; ++method)
+    {
+        int numSamples = 0;
+        int methodMismatches = 0;
+        uint64 totalCycles = 0;
+        
+        for (int r = 0; r < repeats; ++r)
+        {
+            if (method == 0)
+            {
+                uint64 startCycles = ReadTSC();
+                FloodIndexBuild(&index, deck->Bits, dim, ctx->Connectivity);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                
+                if (r == 0)
+                {
+                    int numLabels = Flood_Label(ctx, deck->Bits, dim, labels, 0);
+                    if (!IndexMatchesLabels(&index, labels, numLabels, dim, labelRegions)) ++methodMismatches;
+                }
+                continue;
+            }
+            
+            memcpy(bits, deck->Bits, size);
+            FloodIndexBuild(&index, bits, dim, ctx->Connectivity);
+            for (int e = 0; e < numEdits; ++e)
+            {
+                uint64 startCycles = ReadTSC();
+                FloodIndexEdit(&index, &edits[e], 1);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                
+                if (r != 0) continue;
+                bits[((size_t)edits[e].Y*dim + edits[e].X) >> 3] ^= 1 << ((edits[e].Y*dim + edits[e].X) & 7);
+                int numLabels = Flood_Label(ctx, bits, dim, labels, 0);
+                if (!IndexMatchesLabels(&index, labels, numLabels, dim, labelRegions)) ++methodMismatches;
+            }
+        }
+        
+        PrintBenchRow(ctx, deck, method == 0 ? "Index Build" : "Index Edit", cycles, numSamples, numSamples, CellsPerNS((uint64)numSamples*dim*dim, totalCycles), methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    FloodIndexFree(&index);
+    free(cycles);
+    free(labelRegions);
+    free(labels);
+    free(edits);
+    free(bits);
+    
+    return mismatches;
+}
+
+// Bounded fills from every seed, once with a cell limit and once with a box around the seed. A fill
+// must be truncated exactly when its reference region breaks the limit, and match it when it isn't.
+int BenchmarkBounded(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, const uint64* refHashes, const int* refCounts, int repeats)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* filled = malloc(size);
+    uint64* cycles = malloc(sizeof(uint64)*(size_t)numSeeds*repeats);
+    int mismatches = 0;
+    
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        int numSamples = 0;
+        int numTruncated = 0;
+        int modeMismatches = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        
+        for (int s = 0; s < numSeeds; ++s)
+        {
+            int seedX = seeds[s]%dim;
+            int seedY = seeds[s]/dim;
+            
+            FloodLimits limits;
+            memset(&limits, 0, sizeof(limits));
+            if (mode == 0)
+            {
+                limits.MaxCells = 200;
+            }
+            else
+            {
+                limits.UseBox = true;
+                limits.MinX = seedX - 16;
+                limits.MinY = seedY - 16;
+                limits.MaxX = seedX + 15;
+                limits.MaxY = seedY + 15;
+            }
+            
+            bool truncated = false;
+            for (int r = 0; r < repeats; ++r)
+            {
+                memset(filled, 0, size);
+                
+                uint64 startCycles = ReadTSC();
+                int numFilled = Flood_Bounded(ctx, deck->Bits, dim, filled, seedX, seedY, &limits, &truncated);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                totalCells += numFilled;
+            }
+            numTruncated += truncated;
+            
+            // The reference region breaks the limit if it is too big or a full fill leaves the box
+            bool refBreaks = false;
+            if (mode == 0)
+            {
+                refBreaks = refCounts[s] > limits.MaxCells;
+            }
+            else if (truncated)
+            {
+                memset(filled, 0, size);
+                Flood_Dispatch(ctx, deck->Bits, dim, filled, seedX, seedY);
+                for (int y = 0; y < dim && !refBreaks; ++y)
+                {
+                    for (int x = 0; x < dim; ++x)
+                    {
+                        if (GetCell(filled, dim, x, y) && (x < limits.MinX || x > limits.MaxX || y < limits.MinY || y > limits.MaxY))
+                        {
+                            refBreaks = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                refBreaks = false;
+            }
+            
+            if (truncated != refBreaks || (!truncated && HashDeck(filled, size) != refHashes[s]))
+            {
+                ++modeMismatches;
+            }
+        }
+        
+        if (numSamples == 0) break;
+        
+        char name[64];
+        snprintf(name, sizeof(name), "%s, %d cut", mode == 0 ? "Bounded, 200 Cells" : "Bounded, 32x32 Box", numTruncated);
+        
+        PrintBenchRow(ctx, deck, name, cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), modeMismatches != 0);
+        
+        mismatches += modeMismatches;
+    }
+    
+    free(cycles);
+    free(filled);
+    
+    return mismatches;
+}
+
+// Region stats from every seed, from a dispatched fill and a scan of the result, then gathered during
+// the fill by Flood_Stats. Both must agree field for field.
+int BenchmarkStats(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, const int* refCounts, int repeats)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* filled = malloc(size);
+    FloodStats* refStats = malloc(sizeof(FloodStats)*numSeeds);
+    uint64* cycles = malloc(sizeof(uint64)*(size_t)numSeeds*repeats);
+    int mismatches = 0;
+    
+    for (int method = 0; method < 2; ++method)
+    {
+        int numSamples = 0;
+        int methodMismatches = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        
+        for (int s = 0; s < numSeeds; ++s)
+        {
+            FloodStats stats;
+            for (int r = 0; r < repeats; ++r)
+            {
+                memset(filled, 0, size);
+                
+                uint64 startCycles = ReadTSC();
+                if (method == 0)
+                {
+                    Flood_Dispatch(ctx, deck->Bits, dim, filled, seeds[s]%dim, seeds[s]/dim);
+                    FloodStatsOfDeck(filled, dim, &stats);
+                }
+                else
+                {
+                    Flood_Stats(ctx, deck->Bits, dim, filled, seeds[s]%dim, seeds[s]/dim, &stats);
+                }
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                totalCells += refCounts[s];
+            }
+            
+            if (method == 0) refStats[s] = stats;
+            else if (memcmp(&stats, &refStats[s], sizeof(stats)) != 0 || stats.Area != (uint64)refCounts[s]) ++methodMismatches;
+        }
+        
+        PrintBenchRow(ctx, deck, method == 0 ? "Fill Then Scan Stats" : "Stats During Fill", cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    free(cycles);
+    free(refStats);
+    free(filled);
+    
+    return mismatches;
+}
+
+// Plain queue BFS over cells, the reference for the distance fills. Returns the number of cells reached.
+static int BenchDistances(const uint8* deck, int dim, int connectivity, int seedX, int seedY, uint16* distances, int* queue)
+{
+    for (int i = 0; i < dim*dim; ++i) distances[i] = FLOOD_DISTANCE_UNREACHED;
+    if (!GetCell(deck, dim, seedX, seedY)) return 0;
+    
+    int head = 0;
+    int tail = 0;
+    distances[seedY*dim + seedX] = 0;
+    queue[tail++] = seedY*dim + seedX;
+    while (head < tail)
+    {
+        int cell = queue[head++];
+        int x = cell%dim;
+        int y = cell/dim;
+        uint16 distance = distances[cell] < FLOOD_DISTANCE_UNREACHED - 1 ? distances[cell] + 1 : distances[cell];
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                int nx = x + dx;
+                int ny = y + dy;
+                if ((dx == 0 && dy == 0) || (connectivity == 4 && dx != 0 && dy != 0)) continue;
+                if (nx < 0 || nx >= dim || ny < 0 || ny >= dim) continue;
+                if (distances[ny*dim + nx] != FLOOD_DISTANCE_UNREACHED || !GetCell(deck, dim, nx, ny)) continue;
+                
+                distances[ny*dim + nx] = distance;
+                queue[tail++] = ny*dim + nx;
+            }
+        }
+    }
+    return tail;
+}
+
+// Step distances from up to 256 of the seeds, first by a scalar BFS, then with Flood_Distances, then as
+// the first 64 fronts from Flood_Wavefronts. Distance maps must match the BFS exactly, and each front
+// must hold the cells the BFS put at its distance.
+int BenchmarkDistances(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, int repeats)
+{
+    const int maxFronts = 64;
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    int step = numSeeds > 256 ? numSeeds/256 : 1;
+    uint8* filled = malloc(size);
+    uint8* fronts = malloc(size*maxFronts);
+    uint16* refDistances = malloc(sizeof(uint16)*dim*dim);
+    uint16* distances = malloc(sizeof(uint16)*dim*dim);
+    int* queue = malloc(sizeof(int)*dim*dim);
+    uint64* cycles = malloc(sizeof(uint64)*((size_t)numSeeds/step + 1)*repeats);
+    int mismatches = 0;
+    
+    for (int method = 0; method < 3; ++method)
+    {
+        int numSamples = 0;
+        int methodMismatches = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        
+        for (int s = 0; s < numSeeds; s += step)
+        {
+            int seedX = seeds[s]%dim;
+            int seedY = seeds[s]/dim;
+            int numReached = 0;
+            int numFronts = 0;
+            for (int r = 0; r < repeats; ++r)
+            {
+                memset(filled, 0, size);
+                
+                uint64 startCycles = ReadTSC();
+                if (method == 0) numReached = BenchDistances(deck->Bits, dim, ctx->Connectivity, seedX, seedY, refDistances, queue);
+                else if (method == 1) numFronts = Flood_Distances(ctx, deck->Bits, dim, filled, seedX, seedY, distances);
+                else numFronts = Flood_Wavefronts(ctx, deck->Bits, dim, filled, seedX, seedY, fronts, maxFronts);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+            }
+            if (method == 0)
+            {
+                totalCells += (uint64)numReached*repeats;
+                continue;
+            }
+            
+            // The reference is rerun for each seed, the BFS pass keeps only the last one
+            numReached = BenchDistances(deck->Bits, dim, ctx->Connectivity, seedX, seedY, refDistances, queue);
+            int refFronts = 0;
+            int numChecked = 0;
+            bool match = true;
+            for (int i = 0; i < dim*dim; ++i)
+            {
+                uint16 distance = refDistances[i];
+                bool reached = distance != FLOOD_DISTANCE_UNREACHED;
+                if (reached && distance + 1 > refFronts) refFronts = distance + 1;
+                
+                if (method == 1)
+                {
+                    match &= distances[i] == distance && GetCell(filled, dim, i%dim, i/dim) == reached;
+                    numChecked += reached;
+                }
+                else
+                {
+                    bool inFronts = reached && distance < maxFronts;
+                    match &= GetCell(filled, dim, i%dim, i/dim) == inFronts;
+                    for (int f = 0; f < numFronts; ++f)
+                    {
+                        match &= GetCell(fronts + f*size, dim, i%dim, i/dim) == (inFronts && distance == f);
+                    }
+                    numChecked += inFronts;
+                }
+            }
+            // Past the saturated distance the BFS can no longer tell how many fronts there were
+            if (refFronts < FLOOD_DISTANCE_UNREACHED) match &= numFronts == (method == 1 ? refFronts : (refFronts < maxFronts ? refFronts : maxFronts));
+            if (!match) ++methodMismatches;
+            totalCells += (uint64)numChecked*repeats;
+        }
+        
+        if (numSamples == 0) break;
+        
+        PrintBenchRow(ctx, deck, method == 0 ? "Scalar BFS Distances" : method == 1 ? "Wavefront Distances" : "Wavefront Planes, 64 Steps", cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    free(cycles);
+    free(queue);
+    free(distances);
+    free(refDistances);
+    free(fronts);
+    free(filled);
+    
+    return mismatches;
+}
+
+// Fills from up to 256 of the seeds that fall inside a disc shaped zone, first the old way with a combined
+// bitdeck & clip deck allocated and built for every query and a dispatched fill, then with Flood_Clipped.
+// Both fills must match.
+int BenchmarkClipped(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, int repeats)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    int step = numSeeds > 256 ? numSeeds/256 : 1;
+    uint8* clip = calloc(size, 1);
+    uint8* refFilled = malloc(size);
+    uint8* filled = malloc(size);
+    uint64* cycles = malloc(sizeof(uint64)*((size_t)numSeeds/step + 1)*repeats);
+    int mismatches = 0;
+    
+    int64 radius = (int64)dim*3/8;
+    for (int y = 0; y < dim; ++y)
+    {
+        for (int x = 0; x < dim; ++x)
+        {
+            int64 dx = x - dim/2;
+            int64 dy = y - dim/2;
+            if (dx*dx + dy*dy <= radius*radius) SetCell(clip, dim, x, y);
+        }
+    }
+    
+    for (int method = 0; method < 2; ++method)
+    {
+        int numSamples = 0;
+        int methodMismatches = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        
+        for (int s = 0; s < numSeeds; s += step)
+        {
+            int seedX = seeds[s]%dim;
+            int seedY = seeds[s]/dim;
+            if (!GetCell(clip, dim, seedX, seedY)) continue;
+            
+            int numFilled = 0;
+            for (int r = 0; r < repeats; ++r)
+            {
+                uint8* result = method == 0 ? refFilled : filled;
+                memset(result, 0, size);
+                
+                uint64 startCycles = ReadTSC();
+                if (method == 0)
+                {
+                    uint8* combined = malloc(size);
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        combined[i] = deck->Bits[i] & clip[i];
+                    }
+                    numFilled = Flood_Dispatch(ctx, combined, dim, result, seedX, seedY);
+                    free(combined);
+                }
+                else numFilled = Flood_Clipped(ctx, deck->Bits, clip, dim, result, seedX, seedY);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+            }
+            totalCells += (uint64)numFilled*repeats;
+            
+            if (method == 1)
+            {
+                uint8* combined = malloc(size);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    combined[i] = deck->Bits[i] & clip[i];
+                }
+                memset(refFilled, 0, size);
+                int refCount = Flood_Dispatch(ctx, combined, dim, refFilled, seedX, seedY);
+                free(combined);
+                if (numFilled != refCount || memcmp(filled, refFilled, size) != 0) ++methodMismatches;
+            }
+        }
+        
+        if (numSamples == 0) break;
+        
+        PrintBenchRow(ctx, deck, method == 0 ? "Clip by Combined Deck" : "Clip in Row Loads", cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    free(cycles);
+    free(filled);
+    free(refFilled);
+    free(clip);
+    
+    return mismatches;
+}
+
+// Edits a copy of the deck a random cell toggle at a time while keeping the fill of a seed up to date,
+// first by refilling from scratch after every edit, then with Flood_Update. The fill after every edit
+// must match between the two. Cells/ns counts the region kept up to date per edit.
+int BenchmarkUpdate(FloodContext* ctx, const BenchDeck* deck, const int* seeds, int numSeeds, int repeats)
+{
+    const int numRuns = 4;
+    const int numEdits = 64;
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* bits = malloc(size);
+    uint8* filled = malloc(size);
+    FloodEdit* edits = malloc(sizeof(FloodEdit)*numRuns*numEdits);
+    uint64* refHashes = malloc(sizeof(uint64)*numRuns*numEdits);
+    int* refCounts = malloc(sizeof(int)*numRuns*numEdits);
+    uint64* cycles = malloc(sizeof(uint64)*(size_t)numRuns*numEdits*repeats);
+    int mismatches = 0;
+    
+    // Each edit flips its cell, which takes the deck as edited so far
+    for (int i = 0; i < numRuns*numEdits; ++i)
+    {
+        if (i % numEdits == 0) memcpy(bits, deck->Bits, size);
+        
+        int x = (int)(BenchRand() % dim);
+        int y = (int)(BenchRand() % dim);
+        edits[i].X = x;
+        edits[i].Y = y;
+        edits[i].Set = !GetCell(bits, dim, x, y);
+        bits[((size_t)y*dim + x) >> 3] ^= 1 << ((y*dim + x) & 7);
+    }
+    
+    for (int method = 0; method < 2; ++method)
+    {
+        int numSamples = 0;
+        int methodMismatches = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        
+        for (int run = 0; run < numRuns; ++run)
+        {
+            int seedX = seeds[(run*numSeeds)/numRuns]%dim;
+            int seedY = seeds[(run*numSeeds)/numRuns]/dim;
+            
+            for (int r = 0; r < repeats; ++r)
+            {
+                memcpy(bits, deck->Bits, size);
+                memset(filled, 0, size);
+                int numFilled = Flood_Dispatch(ctx, bits, dim, filled, seedX, seedY);
+                
+                for (int e = 0; e < numEdits; ++e)
+                {
+                    const FloodEdit* edit = &edits[run*numEdits + e];
+                    
+                    uint64 startCycles = ReadTSC();
+                    if (method == 0)
+                    {
+                        bits[((size_t)edit->Y*dim + edit->X) >> 3] ^= 1 << ((edit->Y*dim + edit->X) & 7);
+                        memset(filled, 0, size);
+                        numFilled = Flood_Dispatch(ctx, bits, dim, filled, seedX, seedY);
+                    }
+                    else
+                    {
+                        numFilled += Flood_Update(ctx, bits, dim, filled, seedX, seedY, edit, 1);
+                    }
+                    uint64 interval = ReadTSC() - startCycles;
+                    
+                    cycles[numSamples++] = interval;
+                    totalCycles += interval;
+                    totalCells += numFilled;
+                    
+                    if (r != 0) continue;
+                    if (method == 0)
+                    {
+                        refHashes[run*numEdits + e] = HashDeck(filled, size);
+                        refCounts[run*numEdits + e] = numFilled;
+                    }
+                    else if (HashDeck(filled, size) != refHashes[run*numEdits + e] || numFilled != refCounts[run*numEdits + e])
+                    {
+                        ++methodMismatches;
+                    }
+                }
+            }
+        }
+        
+        PrintBenchRow(ctx, deck, method == 0 ? "Refill After Edit" : "Update After Edit", cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    free(cycles);
+    free(refCounts);
+    free(refHashes);
+    free(edits);
+    free(filled);
+    free(bits);
+    
+    return mismatches;
+}
+
+// Returns the number of seeds whose result did not match the reference algorithm.
+int BenchmarkDeck(FloodContext* ctx, const BenchDeck* deck, int repeats, int maxSeeds)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* filled = malloc(size);
+    
+    int numSeeds = 0;
+    int* seeds = malloc(sizeof(int)*dim*dim);
+    for (int i = 0; i < dim*dim; ++i)
+    {
+        if (GetCell(deck->Bits, dim, i%dim, i/dim))
+        {
+            seeds[numSeeds++] = i;
+        }
+    }
+    
+    if (numSeeds > maxSeeds)
+    {
+        for (int s = 0; s < maxSeeds; ++s)
+        {
+            seeds[s] = seeds[(int)(((long long)s*numSeeds)/maxSeeds)];
+        }
+        numSeeds = maxSeeds;
+    }
+    
+    uint64* refHashes = malloc(sizeof(uint64)*Max(numSeeds, 1));
+    int* refCounts = malloc(sizeof(int)*Max(numSeeds, 1));
+    uint64* cycles = malloc(sizeof(uint64)*Max((size_t)numSeeds*repeats, 1));
+    int mismatches = 0;
+    
+    for (int algo = 0; algo < numAlgos; ++algo)
+    {
+        if (!AlgoSupportsDim(algo, dim)) continue;
+        
+        int numSamples = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        int algoMismatches = 0;
+        
+        for (int s = 0; s < numSeeds; ++s)
+        {
+            int seedX = seeds[s]%dim;
+            int seedY = seeds[s]/dim;
+            int seedFilled = 0;
+            
+            for (int r = 0; r < repeats; ++r)
+            {
+                memset(filled, 0, size);
+                
+                uint64 startCycles = ReadTSC();
+                seedFilled = Flood(ctx, algo, deck->Bits, dim, filled, seedX, seedY);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                totalCells += seedFilled;
+            }
+            
+            uint64 hash = HashDeck(filled, size);
+            if (algo == 0)
+            {
+                refHashes[s] = hash;
+                refCounts[s] = seedFilled;
+            }
+            else if (hash != refHashes[s])
+            {
+                ++algoMismatches;
+            }
+        }
+        
+        if (numSamples == 0) continue;
+        
+        PrintBenchRow(ctx, deck, AlgoName(algo), cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), algoMismatches != 0);
+            
+        mismatches += algoMismatches;
+    }
+    
+    if (numSeeds > 0)
+    {
+        mismatches += BenchmarkBatch(ctx, deck, seeds, numSeeds, refHashes, refCounts, repeats);
+        mismatches += BenchmarkBounded(ctx, deck, seeds, numSeeds, refHashes, refCounts, repeats);
+        mismatches += BenchmarkStats(ctx, deck, seeds, numSeeds, refCounts, repeats);
+        mismatches += BenchmarkUpdate(ctx, deck, seeds, numSeeds, repeats);
+        mismatches += BenchmarkDistances(ctx, deck, seeds, numSeeds, repeats);
+        mismatches += BenchmarkClipped(ctx, deck, seeds, numSeeds, repeats);
+    }
+    mismatches += BenchmarkLabel(ctx, deck, repeats);
+    mismatches += BenchmarkEnclosed(ctx, deck, repeats);
+    mismatches += BenchmarkReachable(ctx, deck, seeds, numSeeds, repeats);
+    mismatches += BenchmarkIndex(ctx, deck, repeats);
+    
+    free(cycles);
+    free(refCounts);
+    free(refHashes);
+    free(seeds);
+    free(filled);
+    
+    return mismatches;
+}
+
+// Fills a large deck from a few seeds single threaded with the dispatched fill, then tiled on each pool,
+// without and then with an occupancy summary. Tiled results must hash the same as the single threaded
+// ones. Then times summary edits, which must leave the same counts as a fresh build of the edited deck.
+int BenchmarkTiled(FloodContext* ctx, const BenchDeck* deck, int repeats, FloodPool** pools, int numPools)
+{
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    uint8* filled = malloc(size);
+    uint64* cycles = malloc(sizeof(uint64)*repeats*4);
+    
+    // A few seeds spread over the deck, each moved forward to the next set cell
+    int seeds[4];
+    int numSeeds = 0;
+    for (int s = 0; s < 4; ++s)
+    {
+        int cell = (int)(((long long)(2*s + 1)*dim*dim)/8);
+        while (cell < dim*dim && !GetCell(deck->Bits, dim, cell%dim, cell/dim)) ++cell;
+        if (cell < dim*dim) seeds[numSeeds++] = cell;
+    }
+    if (numSeeds == 0)
+    {
+        free(cycles);
+        free(filled);
+        return 0;
+    }
+    
+    FloodSummary summary;
+    FloodSummaryInit(&summary);
+    FloodSummaryBuild(&summary, deck->Bits, dim);
+    
+    uint64 refHashes[4];
+    int mismatches = 0;
+    for (int p = -1; p < 2*numPools; ++p)
+    {
+        FloodPool* pool = p < 0 ? 0 : pools[p % numPools];
+        const FloodSummary* poolSummary = p >= numPools ? &summary : 0;
+        int numSamples = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        int poolMismatches = 0;
+        
+        for (int s = 0; s < numSeeds; ++s)
+        {
+            for (int r = 0; r < repeats; ++r)
+            {
+                memset(filled, 0, size);
+                
+                uint64 startCycles = ReadTSC();
+                int numFilled = p < 0 ?
+                    Flood_Dispatch(ctx, deck->Bits, dim, filled, seeds[s]%dim, seeds[s]/dim) :
+                    Flood_Tiled(ctx, pool, poolSummary, deck->Bits, dim, filled, seeds[s]%dim, seeds[s]/dim);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                totalCells += numFilled;
+            }
+            
+            uint64 hash = HashDeck(filled, size);
+            if (p < 0)
+            {
+                refHashes[s] = hash;
+            }
+            else if (hash != refHashes[s])
+            {
+                ++poolMismatches;
+            }
+        }
+        
+        char name[64];
+        if (p < 0) snprintf(name, sizeof(name), "%s", AlgoName(8));
+        else snprintf(name, sizeof(name), "%s, %d workers", poolSummary ? "Tiled + Summary" : "Tiled Fill", pool->NumWorkers);
+        
+        PrintBenchRow(ctx, deck, name, cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), poolMismatches != 0);
+        
+        mismatches += poolMismatches;
+    }
+    
+    // Random toggles on a copy, each timed on its own
+    const int numEdits = 1024;
+    uint64* editCycles = malloc(sizeof(uint64)*numEdits);
+    memcpy(filled, deck->Bits, size);
+    for (int e = 0; e < numEdits; ++e)
+    {
+        FloodEdit edit;
+        edit.X = (int)(BenchRand() % dim);
+        edit.Y = (int)(BenchRand() % dim);
+        edit.Set = !GetCell(filled, dim, edit.X, edit.Y);
+        
+        uint64 startCycles = ReadTSC();
+        FloodSummaryEdit(&summary, filled, &edit, 1);
+        editCycles[e] = ReadTSC() - startCycles;
+    }
+    
+    FloodSummary rebuilt;
+    FloodSummaryInit(&rebuilt);
+    FloodSummaryBuild(&rebuilt, filled, dim);
+    int editMismatch = memcmp(summary.Counts, rebuilt.Counts, sizeof(uint16)*summary.BlocksAcross*summary.BlocksAcross) != 0;
+    
+    PrintBenchRow(ctx, deck, "Summary Edit", editCycles, numEdits, numEdits, -1.0, editMismatch != 0);
+    mismatches += editMismatch;
+    
+    FloodSummaryFree(&rebuilt);
+    FloodSummaryFree(&summary);
+    free(editCycles);
+    free(cycles);
+    free(filled);
+    
+    return mismatches;
+}
+
+// Fills 1024 copies of a 64x64 deck from seeds spread over its open cells, one deck at a time with the
+// dispatched fill and then all at once with Flood_Sliced. Every deck's fill must match. Cycles are per
+// deck, and the name gives the decks filled per second.
+int BenchmarkSliced(FloodContext* ctx, const BenchDeck* deck, int repeats)
+{
+    const int numDecks = 1024;
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    
+    int numOpen = 0;
+    for (int i = 0; i < dim*dim; ++i) numOpen += GetCell(deck->Bits, dim, i%dim, i/dim);
+    if (numOpen == 0) return 0;
+    
+    uint8* bitdecks = malloc(size*numDecks);
+    uint8* reference = calloc(numDecks, size);
+    uint8* result = malloc(size*numDecks);
+    FloodSeed* seeds = malloc(sizeof(FloodSeed)*numDecks);
+    uint64* cycles = malloc(sizeof(uint64)*repeats);
+    
+    // Seed k lands on open cell k*numOpen/numDecks, found by counting open cells in raster order
+    for (int d = 0, i = 0, seen = 0; d < numDecks; ++d)
+    {
+        int target = (int)(((long long)d*numOpen)/numDecks);
+        for (; seen <= target; ++i) seen += GetCell(deck->Bits, dim, i%dim, i/dim);
+        seeds[d].X = (i-1)%dim;
+        seeds[d].Y = (i-1)/dim;
+        memcpy(bitdecks + d*size, deck->Bits, size);
+    }
+    
+    int mismatches = 0;
+    for (int method = 0; method < 2; ++method)
+    {
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            memset(result, 0, size*numDecks);
+            
+            uint64 startCycles = ReadTSC();
+            if (method == 0)
+            {
+                for (int d = 0; d < numDecks; ++d)
+                {
+                    totalCells += Flood_Dispatch(ctx, bitdecks + d*size, dim, result + d*size, seeds[d].X, seeds[d].Y);
+                }
+            }
+            else
+            {
+                totalCells += Flood_Sliced(ctx, bitdecks, result, seeds, numDecks);
+            }
+            uint64 interval = ReadTSC() - startCycles;
+            
+            cycles[r] = interval/numDecks;
+            totalCycles += interval;
+            
+            if (method == 0 && r == 0) memcpy(reference, result, size*numDecks);
+        }
+        
+        int methodMismatches = 0;
+        for (int d = 0; d < numDecks; ++d)
+        {
+            if (memcmp(result + d*size, reference + d*size, size) != 0) ++methodMismatches;
+        }
+        
+        PrintBenchRow(ctx, deck, method == 0 ? "Per Deck" : "Sliced", cycles, repeats, numDecks*repeats, CellsPerNS(totalCells, totalCycles), methodMismatches != 0);
+        
+        mismatches += methodMismatches;
+    }
+    
+    free(cycles);
+    free(seeds);
+    free(result);
+    free(reference);
+    free(bitdecks);
+    
+    return mismatches;
+}
+
+static void CountJobDone(FloodJob* job, void* arg)
+{
+    (void)job;
+    // Only ever called for the single worker pool
+    ++*(int*)arg;
+}
+
+// Fills 4096 copies of a 64x64 deck from seeds spread over its open cells as one FloodJobsRun batch on
+// each pool. Every job's fill must match a single threaded fill from its seed. Cycles are per job, and
+// the name gives the jobs finished per second.
+int BenchmarkJobs(FloodContext* ctx, const BenchDeck* deck, int repeats, FloodPool** pools, int numPools)
+{
+    const int numJobs = 4096;
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    
+    int numOpen = 0;
+    for (int i = 0; i < dim*dim; ++i) numOpen += GetCell(deck->Bits, dim, i%dim, i/dim);
+    if (numOpen == 0) return 0;
+    
+    uint8* bitdecks = malloc(size*numJobs);
+    uint8* reference = calloc(numJobs, size);
+    uint8* result = malloc(size*numJobs);
+    FloodJob* jobs = malloc(sizeof(FloodJob)*numJobs);
+    uint64* cycles = malloc(sizeof(uint64)*repeats);
+    
+    // Job k seeds open cell k*numOpen/numJobs, found by counting open cells in raster order
+    for (int j = 0, i = 0, seen = 0; j < numJobs; ++j)
+    {
+        int target = (int)(((long long)j*numOpen)/numJobs);
+        for (; seen <= target; ++i) seen += GetCell(deck->Bits, dim, i%dim, i/dim);
+        memcpy(bitdecks + j*size, deck->Bits, size);
+        
+        FloodJob* job = &jobs[j];
+        job->Bitdeck = bitdecks + j*size;
+        job->Dim = dim;
+        job->Filled = result + j*size;
+        job->SeedX = (i-1)%dim;
+        job->SeedY = (i-1)/dim;
+        Flood_Dispatch(ctx, job->Bitdeck, dim, reference + j*size, job->SeedX, job->SeedY);
+    }
+    
+    int mismatches = 0;
+    for (int p = 0; p < numPools; ++p)
+    {
+        FloodPool* pool = pools[p];
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        int numDone = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            memset(result, 0, size*numJobs);
+            
+            uint64 startCycles = ReadTSC();
+            FloodJobsRun(pool, ctx->Connectivity, jobs, numJobs, pool->NumWorkers == 1 ? CountJobDone : 0, &numDone);
+            uint64 interval = ReadTSC() - startCycles;
+            
+            cycles[r] = interval/numJobs;
+            totalCycles += interval;
+            for (int j = 0; j < numJobs; ++j) totalCells += jobs[j].NumFilled;
+        }
+        
+        int poolMismatches = pool->NumWorkers == 1 && numDone != numJobs*repeats ? 1 : 0;
+        for (int j = 0; j < numJobs; ++j)
+        {
+            if (memcmp(result + j*size, reference + j*size, size) != 0) ++poolMismatches;
+        }
+        
+        char name[64];
+        snprintf(name, sizeof(name), "Jobs, %d worker%s", pool->NumWorkers, pool->NumWorkers > 1 ? "s" : "");
+        PrintBenchRow(ctx, deck, name, cycles, repeats, numJobs*repeats, CellsPerNS(totalCells, totalCycles), poolMismatches != 0);
+        
+        mismatches += poolMismatches;
+    }
+    
+    free(cycles);
+    free(jobs);
+    free(result);
+    free(reference);
+    free(bitdecks);
+    
+    return mismatches;
+}
+
+// Saves the deck as a raw plane file and as a compressed one, and loads each back. Loaded rows must be
+// the rows saved. Cells/ns is the plane size over the save or load time, and the name gives the file
+// size against the bare bits of the deck.
+int BenchmarkFiles(const BenchDeck* deck, int repeats)
+{
+    const char* path = "floodbench_deck.bitplane";
+    int dim = deck->Dim;
+    int rowWords = (dim + 63)/64;
+    size_t rowsBytes = (size_t)dim*rowWords*sizeof(uint64);
+    int numSamples = 8*repeats;
+    int mismatches = 0;
+    
+    uint64* rows = calloc(1, rowsBytes);
+    for (int y = 0; y < dim; ++y)
+    {
+        for (int x = 0; x < dim; ++x)
+        {
+            if (GetCell(deck->Bits, dim, x, y)) rows[(size_t)y*rowWords + x/64] |= 1llu << (x%64);
+        }
+    }
+    uint64* cycles = malloc(sizeof(uint64)*numSamples);
+    
+    for (int compress = 0; compress < 2; ++compress)
+    {
+        for (int load = 0; load < 2; ++load)
+        {
+            int fileMismatches = 0;
+            uint64 totalCycles = 0;
+            
+            for (int r = 0; r < numSamples; ++r)
+            {
+                uint64 startCycles = ReadTSC();
+                int width = 0;
+                int height = 0;
+                uint64* loaded = 0;
+                bool saved = true;
+                if (load)
+                {
+                    loaded = FloodPlaneLoad(path, &width, &height);
+                }
+                else
+                {
+                    saved = FloodPlaneSave(path, rows, dim, dim, compress != 0);
+                }
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[r] = interval;
+                totalCycles += interval;
+                
+                if (load && !(loaded && width == dim && height == dim && memcmp(loaded, rows, rowsBytes) == 0)) ++fileMismatches;
+                if (!saved) ++fileMismatches;
+                free(loaded);
+            }
+            
+            long fileBytes = 0;
+            FILE* fh = fopen(path, "rb");
+            if (fh)
+            {
+                fseek(fh, 0, SEEK_END);
+                fileBytes = ftell(fh);
+                fclose(fh);
+            }
+            
+            char name[64];
+            snprintf(name, sizeof(name), "%s %s, %.1f%%", load ? "Load" : "Save", compress ? "Compressed" : "Raw",
+                100.0*(double)fileBytes/(double)DeckBytes(dim));
+            
+            PrintBenchRow(0, deck, name, cycles, numSamples, numSamples, CellsPerNS((uint64)dim*dim*numSamples, totalCycles), fileMismatches != 0);
+            
+            mismatches += fileMismatches;
+        }
+    }
+    
+    remove(path);
+    free(cycles);
+    free(rows);
+    
+    return mismatches;
+}
+
+// Writes the deck to a plane file and fills it from a few seeds with Flood_Streamed into a fresh fill
+// file, once with room to map the whole plane and once mapping a sixteenth of it at a time. Fill files
+// must hash the same as the dispatched fill in memory.
+int BenchmarkStreamed(FloodContext* ctx, const BenchDeck* deck, int repeats)
+{
+    const char* bitsPath = "floodbench_bits.bitplane";
+    const char* fillPath = "floodbench_fill.bitplane";
+    int dim = deck->Dim;
+    size_t size = DeckBytes(dim);
+    int mismatches = 0;
+    
+    FloodPlaneFile bits;
+    FloodPlaneFile filled;
+    FloodPlaneView view;
+    if (!FloodPlaneCreate(&bits, bitsPath, dim, dim))
+    {
+        printf("Could not create %s\n", bitsPath);
+        return 0;
+    }
+    // Large decks are whole words per row, so a packed row and a file row are the same bytes
+    uint8* rows = (uint8*)FloodPlaneMapRows(&bits, 0, dim, &view);
+    for (int y = 0; y < dim; ++y)
+    {
+        memcpy(rows + (size_t)y*bits.Header.RowStride, deck->Bits + (size_t)y*dim/8, dim/8);
+    }
+    FloodPlaneUnmap(&view);
+    
+    // Same seeds as the tiled fill
+    int seeds[4];
+    int numSeeds = 0;
+    for (int s = 0; s < 4; ++s)
+    {
+        int cell = (int)(((long long)(2*s + 1)*dim*dim)/8);
+        while (cell < dim*dim && !GetCell(deck->Bits, dim, cell%dim, cell/dim)) ++cell;
+        if (cell < dim*dim) seeds[numSeeds++] = cell;
+    }
+    
+    uint8* reference = malloc(size);
+    uint8* result = malloc(size);
+    uint64* cycles = malloc(sizeof(uint64)*repeats*4);
+    size_t budgets[2] = { 2*(size_t)bits.Header.RowStride*(dim + 2), 2*(size_t)bits.Header.RowStride*(dim/16 + 2) };
+    
+    for (int b = 0; b < 2 && numSeeds > 0; ++b)
+    {
+        int numSamples = 0;
+        int budgetMismatches = 0;
+        uint64 totalCells = 0;
+        uint64 totalCycles = 0;
+        
+        for (int s = 0; s < numSeeds; ++s)
+        {
+            memset(reference, 0, size);
+            Flood_Dispatch(ctx, deck->Bits, dim, reference, seeds[s]%dim, seeds[s]/dim);
+            
+            for (int r = 0; r < repeats; ++r)
+            {
+                if (!FloodPlaneCreate(&filled, fillPath, dim, dim)) break;
+                
+                uint64 startCycles = ReadTSC();
+                int64 numFilled = Flood_Streamed(ctx, &bits, &filled, seeds[s]%dim, seeds[s]/dim, budgets[b]);
+                uint64 interval = ReadTSC() - startCycles;
+                
+                cycles[numSamples++] = interval;
+                totalCycles += interval;
+                totalCells += numFilled > 0 ? numFilled : 0;
+                
+                const uint8* fillRows = (const uint8*)FloodPlaneMapRows(&filled, 0, dim, &view);
+                for (int y = 0; y < dim; ++y)
+                {
+                    memcpy(result + (size_t)y*dim/8, fillRows + (size_t)y*filled.Header.RowStride, dim/8);
+                }
+                FloodPlaneUnmap(&view);
+                FloodPlaneClose(&filled);
+                
+                if (r == 0 && memcmp(result, reference, size) != 0) ++budgetMismatches;
+            }
+        }
+        if (numSamples == 0) break;
+        
+        char name[64];
+        snprintf(name, sizeof(name), "Streamed Fill, 1/%d mapped", b == 0 ? 1 : 16);
+        
+        PrintBenchRow(ctx, deck, name, cycles, numSamples, numSamples, CellsPerNS(totalCells, totalCycles), budgetMismatches != 0);
+        
+        mismatches += budgetMismatches;
+    }
+    
+    FloodPlaneClose(&bits);
+    remove(bitsPath);
+    remove(fillPath);
+    free(cycles);
+    free(result);
+    free(reference);
+    
+    return mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    int repeats = 1;
+    int maxSeeds = 4096;
+    int numWorkers = 0;
+    
+    BenchDeck decks[64];
+    int numDecks = 0;
+    
+    InitializeTSCFrequency();
+    InitializeFloodKernels();
+    printf("Flood kernels: %s\n", FloodTierName(FloodActiveTier()));
+    
+    FillDeck(AddBenchDeck(decks, &numDecks, "full", dim)->Bits);
+    FillWorstCase(AddBenchDeck(decks, &numDecks, "worstcase", dim)->Bits);
+    FillRandom(AddBenchDeck(decks, &numDecks, "random25", dim)->Bits, dim, 25);
+    FillRandom(AddBenchDeck(decks, &numDecks, "random50", dim)->Bits, dim, 50);
+    FillRandom(AddBenchDeck(decks, &numDecks, "random75", dim)->Bits, dim, 75);
+    FillMaze(AddBenchDeck(decks, &numDecks, "maze", dim)->Bits, dim);
+    FillSerpentine(AddBenchDeck(decks, &numDecks, "serpentine", dim)->Bits, dim);
+    
+    // Wider planes for the multi-word algorithms, including one that isn't a multiple of 64
+    const int wideDims[] = { 100, 128, 256, 512 };
+    for (int i = 0; i < (int)(sizeof(wideDims)/sizeof(wideDims[0])); ++i)
+    {
+        int wideDim = wideDims[i];
+        memset(AddBenchDeck(decks, &numDecks, "full", wideDim)->Bits, 0xff, DeckBytes(wideDim));
+        if (wideDim % 8 == 0)
+        {
+            FillWorstCaseDim(AddBenchDeck(decks, &numDecks, "worstcase", wideDim)->Bits, wideDim);
+        }
+        FillRandom(AddBenchDeck(decks, &numDecks, "random75", wideDim)->Bits, wideDim, 75);
+        FillMaze(AddBenchDeck(decks, &numDecks, "maze", wideDim)->Bits, wideDim);
+        FillSerpentine(AddBenchDeck(decks, &numDecks, "serpentine", wideDim)->Bits, wideDim);
+    }
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i+1 < argc)
+        {
+            repeats = atoi(argv[++i]);
+            repeats = repeats > 0 ? repeats : 1;
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+        {
+            maxSeeds = atoi(argv[++i]);
+            maxSeeds = maxSeeds > 0 ? maxSeeds : 1;
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+        {
+            numWorkers = atoi(argv[++i]);
+            numWorkers = numWorkers > 0 ? numWorkers : 0;
+        }
+        else if (numDecks < (int)(sizeof(decks)/sizeof(decks[0])))
+        {
+            FILE* fh = fopen(argv[i], "rb");
+            if (!fh)
+            {
+                printf("Could not open %s\n", argv[i]);
+                continue;
+            }
+            fclose(fh);
+            
+            const char* name = strrchr(argv[i], '/');
+            LoadDeck(AddBenchDeck(decks, &numDecks, name ? name+1 : argv[i], dim)->Bits, argv[i]);
+        }
+    }
+    
+    printf("%-16s %4s %4s  %-28s %8s %10s %10s %10s %10s %10s\n", "deck", "dim", "conn", "algo", "fills", "min", "median", "p99", "cells/ns", "fills/ms");
+    
+    // One context for the whole run, so the timed fills only ever see warm scratch
+    FloodContext floodContext;
+    FloodContextInit(&floodContext);
+    
+    // Batches of jobs and the tiled fill run single threaded and on every worker
+    FloodPool singlePool;
+    FloodPool workerPool;
+    FloodPoolInit(&singlePool, 1);
+    FloodPoolInit(&workerPool, numWorkers);
+    FloodPool* pools[2] = { &singlePool, &workerPool };
+    int numPools = workerPool.NumWorkers > 1 ? 2 : 1;
+    
+    // Every deck is swept with 4-connectivity and again with 8
+    const int connectivities[2] = { 4, 8 };
+    
+    int mismatches = 0;
+    for (int i = 0; i < numDecks; ++i)
+    {
+        // Keep the cells swept per deck about the same as a 64x64 deck swept from every seed
+        int deckSeeds = (int)(((long long)maxSeeds*dim*dim) / ((long long)decks[i].Dim*decks[i].Dim));
+        mismatches += BenchmarkFiles(&decks[i], repeats);
+        for (int c = 0; c < 2; ++c)
+        {
+            floodContext.Connectivity = connectivities[c];
+            mismatches += BenchmarkDeck(&floodContext, &decks[i], repeats, deckSeeds > 16 ? deckSeeds : 16);
+            if (decks[i].Dim == dim) mismatches += BenchmarkSliced(&floodContext, &decks[i], repeats);
+            if (decks[i].Dim == dim) mismatches += BenchmarkJobs(&floodContext, &decks[i], repeats, pools, numPools);
+        }
+        free(decks[i].Bits);
+    }
+    
+    // Large planes for the tiled fill
+    numDecks = 0;
+    memset(AddBenchDeck(decks, &numDecks, "full", 4096)->Bits, 0xff, DeckBytes(4096));
+    FillRandom(AddBenchDeck(decks, &numDecks, "random75", 4096)->Bits, 4096, 75);
+    FillSerpentine(AddBenchDeck(decks, &numDecks, "serpentine", 4096)->Bits, 4096);
+    FillMaze(AddBenchDeck(decks, &numDecks, "maze", 2048)->Bits, 2048);
+    for (int i = 0; i < numDecks; ++i)
+    {
+        mismatches += BenchmarkFiles(&decks[i], repeats);
+        for (int c = 0; c < 2; ++c)
+        {
+            floodContext.Connectivity = connectivities[c];
+            mismatches += BenchmarkTiled(&floodContext, &decks[i], repeats, pools, numPools);
+            mismatches += BenchmarkStreamed(&floodContext, &decks[i], repeats);
+        }
+        free(decks[i].Bits);
+    }
+    
+    FloodPoolFree(&workerPool);
+    FloodPoolFree(&singlePool);
+    FloodContextFree(&floodContext);
+    
+    if (mismatches)
+    {
+        printf("%d fills did not match the reference algorithm\n", mismatches);
+        return 1;
+    }
+    
+    return 0;
+}
+
+#else
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(void)
+{
+    // Initialization
+    //--------------------------------------------------------------------------------------
+    const int rectSize = 15;
+    const int rectMargin = 1;
+    const int rectSpacing = rectSize+rectMargin;
+    const int topMargin = 30;
+    
+    const int screenWidth = rectSpacing*dim + rectMargin;
+    const int screenHeight = rectSpacing*dim + rectMargin + topMargin;
+    
+    InitializeTSCFrequency();
+    InitializeFloodKernels();
+    printf("Flood kernels: %s\n", FloodTierName(FloodActiveTier()));
+
+    InitWindow(screenWidth, screenHeight, "Bitplane Floodfill Tests");
+
+    SetTargetFPS(60);               // Set our game to run at 60 frames-per-second
+    //--------------------------------------------------------------------------------------
+
+
+
+    // 16x16 deck of bits
+
+    uint8* bitdeck = malloc(decksize);
+    uint8* filled = malloc(decksize);
+    uint8* visited = malloc(decksize);
+    uint8* tested = malloc(decksize);
+    
+    // Initial config 
+    FillDeck(bitdeck);
+    ResetDeck(filled);
+    ResetDeck(visited);
+    ResetDeck(tested);
+    
+    
+    unsigned int algoIndex = 0;
+    bool stepMode = false;
+    int iterationsPerFrame = 1;
+    
+    char textBuf[1024];
+    int lastFilledCount = 0;
+    
+    // Just as big as possibly required.
+    int* incrementalFillStack = malloc(sizeof(IncrementalState)*dim*dim);
+    int incrementalFillStackCount = 0;
+    
+    FloodContext floodContext;
+    FloodContextInit(&floodContext);
+    
+    int maxStackSize = 0;
+    int totalTested = 0;
+    
+    // Seed of the fill while it holds a single region, so edits can keep it up to date with Flood_Update
+    int fillSeedX = -1;
+    int fillSeedY = -1;
+    bool fillEmpty = true;
+
+    double lastRuntimeUS = 0.0f;
+
+    // Main game loop
+    while (!WindowShouldClose())    // Detect window close button or ESC key
+    {
+        // Update
+        
+        Vector2 mouseScreenPos = GetMousePosition();
+        int cellX = ((int)mouseScreenPos.x / rectSpacing);
+        int cellY = ((int)mouseScreenPos.y-topMargin) / rectSpacing;
+            
+        if (IsKeyPressed(KEY_S))
+        {
+            stepMode = !stepMode;
+        }            
+        
+        if (IsKeyPressed(KEY_KP_ADD))
+        {
+            iterationsPerFrame++;
+        }
+        if (IsKeyPressed(KEY_KP_SUBTRACT))
+        {
+            iterationsPerFrame = Max(1, iterationsPerFrame-1);
+        }
+            
+        if (incrementalFillStackCount > 0)
+        {
+            if (IsKeyPressed(KEY_ENTER))
+            {
+                ResetDeck(tested);
+                
+                while (incrementalFillStackCount)
+                {
+                    int testCount = 0;
+                    lastFilledCount +=  Flood_Incremental(&floodContext, algoIndex, bitdeck, dim, filled, incrementalFillStack, &incrementalFillStackCount, tested, &testCount);
+                    
+                    maxStackSize = incrementalFillStackCount > maxStackSize ? incrementalFillStackCount : maxStackSize;
+                    totalTested += testCount;
+                }
+                
+                ResetDeck(tested);
+            }
+            else if (!stepMode || IsKeyPressed(KEY_SPACE) || IsKeyPressedRepeat(KEY_SPACE))
+            {
+                ResetDeck(tested);
+                      
+                int remainingIterations = iterationsPerFrame;
+                while (remainingIterations && incrementalFillStackCount)
+                {
+                    int testCount = 0;
+                    lastFilledCount +=  Flood_Incremental(&floodContext, algoIndex, bitdeck, dim, filled, incrementalFillStack, &incrementalFillStackCount, tested, &testCount);
+                    
+                    maxStackSize = incrementalFillStackCount > maxStackSize ? incrementalFillStackCount : maxStackSize;
+                    totalTested += testCount;
+                    
+                    --remainingIterations;
+                }
+            }
+        }
+        else
+        {
+            ResetDeck(tested);
+            
+            if (IsKeyPressed(KEY_SPACE) || IsMouseButtonPressed(MOUSE_BUTTON_RIGHT))
+            {
+                ResetDeck(filled);
+                fillEmpty = true;
+                fillSeedX = fillSeedY = -1;
+            }
+            
+            if (IsKeyPressed(KEY_GRAVE))
+            {
+                FillDeck(bitdeck);
+                fillSeedX = fillSeedY = -1;
+            }
+            
+            if (IsKeyPressed(KEY_W))
+            {
+                FillWorstCase(bitdeck);
+                fillSeedX = fillSeedY = -1;
+            }
+            
+            if (IsKeyPressed(KEY_L))
+            {
+                LoadDeck(bitdeck, "saved.bitplane");
+                fillSeedX = fillSeedY = -1;
+            }
+            
+            if (IsKeyPressed(KEY_F))
+            {
+                SaveDeck(bitdeck, "saved.bitplane");
+            }
+            
+            if (IsKeyPressed(KEY_C))
+            {
+                floodContext.Connectivity = floodContext.Connectivity == 8 ? 4 : 8;
+                fillSeedX = fillSeedY = -1;
+            }
+            
+            if (IsKeyPressed(KEY_DOWN))
+            {
+                algoIndex = (algoIndex + 1) % numAlgos;
+            }
+            else if (IsKeyPressed(KEY_UP))
+            {
+                algoIndex = (algoIndex + numAlgos - 1) % numAlgos;
+            }
+            
+            if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) && fillSeedX >= 0)
+            {
+                FloodEdit edit = { cellX, cellY, IsKeyDown(KEY_LEFT_SHIFT) };
+                
+                uint64 startCycles = ReadTSC();
+                
+                lastFilledCount += Flood_Update(&floodContext, bitdeck, dim, filled, fillSeedX, fillSeedY, &edit, 1);
+                
+                uint64 interval = ReadTSC() - startCycles;
+                lastRuntimeUS = CyclesToSeconds(interval)*1000000;
+            }
+            else if (IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+            {
+                int bitIndex = cellY*dim + cellX;
+                int byte = bitIndex/8;
+                int bit = bitIndex%8;
+                if (IsKeyDown(KEY_LEFT_SHIFT))
+                {
+                   bitdeck[byte] = bitdeck[byte] | (1 << bit);
+                    
+                }
+                else
+                {
+                   bitdeck[byte] = bitdeck[byte] & ~(1 << bit);
+                }
+            }
+            
+            if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE))
+            {
+                maxStackSize = 0;
+                totalTested = 0;
+                
+                 // Edits only maintain a fill of one region, started on an empty deck
+                 fillSeedX = fillSeedY = -1;
+                 if (IsKeyDown(KEY_LEFT_SHIFT))
+                 {
+                    lastFilledCount = Flood_Incremental_Start(&floodContext, algoIndex, bitdeck, dim, filled, incrementalFillStack, &incrementalFillStackCount, cellX, cellY);
+                 }
+                 else
+                 {
+                    uint64 startCycles = ReadTSC();
+                     
+                    lastFilledCount = Flood(&floodContext, algoIndex, bitdeck, dim, filled, cellX, cellY);
+                    
+                    uint64 interval = ReadTSC() - startCycles;
+                    lastRuntimeUS = CyclesToSeconds(interval)*1000000;
+                    
+                    if (fillEmpty)
+                    {
+                        fillSeedX = cellX;
+                        fillSeedY = cellY;
+                    }
+                 }
+                 fillEmpty = false;
+            }
+        }
+        
+
+
+        // Draw
+        //----------------------------------------------------------------------------------
+        BeginDrawing();
+
+            ClearBackground(RAYWHITE);
+            
+            sprintf(textBuf, "Screen pos: (%04d,%04d)  Last filled count: %d  Stack size: %d  Max stack size: %d Total reads: %d Last time: %.3fus", 
+                (int)mouseScreenPos.x, 
+                (int)mouseScreenPos.y, 
+                lastFilledCount, 
+                incrementalFillStackCount, 
+                maxStackSize, 
+                totalTested,
+                lastRuntimeUS);
+                
+            DrawText(textBuf, 0, 0, 12, BLACK);
+            
+            sprintf(textBuf, "Algo name: %s  Connectivity: %d  Step mode: %s  Speed: %d", AlgoName(algoIndex), floodContext.Connectivity, stepMode ? "on" : "off", iterationsPerFrame);
+            
+            DrawText(textBuf, 0, 14, 12, BLACK);
+            
+           for (int y = 0; y < dim; ++y)
+           {
+                for (int x = 0; x < dim; ++x)
+                {
+                    int index = y*dim + x;
+                    int byte = index/8;
+                    int bit = index%8;
+                    bool value = (bitdeck[byte] & (1 << bit)) != 0;
+                    bool isfilled = (filled[byte] & (1 << bit)) != 0;
+                    bool isTested = (tested[byte] & (1 << bit)) != 0;
+                    
+                    if (value)
+                    {
+                        DrawRectangle(
+                            x*rectSpacing + rectMargin, 
+                            y*rectSpacing + rectMargin + topMargin, 
+                            rectSize, 
+                            rectSize, 
+                            isTested ? YELLOW : (isfilled ? RED:DARKDARKBLUE));
+                    }
+                    else
+                    {
+                        DrawRectangleLines(
+                            x*rectSpacing + rectMargin, 
+                            y*rectSpacing + rectMargin + topMargin, 
+                            rectSize, 
+                            rectSize, 
+                            DARKDARKBLUE);
+                    }
+                }
+           }
+
+        EndDrawing();
+        //----------------------------------------------------------------------------------
+    }
+
+    // De-Initialization
+    //--------------------------------------------------------------------------------------
+    CloseWindow();        // Close window and OpenGL context
+    FloodContextFree(&floodContext);
+    //--------------------------------------------------------------------------------------
+
+    return 0;
+}
+
+#endif // FLOODFILL_BENCHMARK
+
+
+int Flood(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    switch (algo)
+    {
+        case 0: return Flood_1(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 1: return Flood_2(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 2: return Flood_3(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 3: return Flood_4(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 4: return Flood_5(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 5: return Flood_6(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 6: return Flood_7(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 7: return Flood_8(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 8: return Flood_Dispatch(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 9: return Flood_9(ctx, bitdeck, dim, filled, seedX, seedY);
+        default: return 0;
+    }
+}
+
+int Flood_Incremental(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
+{
+    switch (algo)
+    {
+        case 0: return Flood_1_Incremental(ctx, bitdeck, dim, filled, stack, stackCount, tested, numTested);
+        case 1: return Flood_2_Incremental(ctx, bitdeck, dim, filled, stack, stackCount, tested, numTested);
+        case 2: return Flood_3_Incremental(ctx, bitdeck, dim, filled, stack, stackCount, tested, numTested);
+        default: return 0;
+    }
+}
+
+int Flood_Incremental_Start(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
+{
+     switch (algo)
+    {
+        case 0: return Flood_1_Incremental_Start(ctx, bitdeck, dim, filled, stack, stackCount, seedX, seedY);
+        case 1: return Flood_2_Incremental_Start(ctx, bitdeck, dim, filled, stack, stackCount, seedX, seedY);
+        case 2: return Flood_3_Incremental_Start(ctx, bitdeck, dim, filled, stack, stackCount, seedX, seedY);
+        default: return 0;
+    }
+}
+
+// Batch fill
+//
+// Regions don't touch, so every region of a batch can share one 'filled' deck. A seed that lands on a
+// filled cell is already answered by the label of that cell. After each new region is filled, the
+// cells it added are exactly filled & ~labeled, found a word at a time, and only those get labelled,
+// so labelling costs one pass over the deck words per region plus one write per filled cell.
+
+// Labels the cells in 'filled' that aren't yet in 'labeled', and adds them to it.
+static void LabelNewCells(const uint8* filled, uint8* labeled, size_t deckBytes, int* labels, int regionId)
+{
+    size_t i = 0;
+    for (; i + 8 <= deckBytes; i += 8)
+    {
+        uint64 fillWord, labeledWord;
+        memcpy(&fillWord, filled + i, sizeof(fillWord));
+        memcpy(&labeledWord, labeled + i, sizeof(labeledWord));
+        
+        uint64 newCells = fillWord & ~labeledWord;
+        if (!newCells) continue;
+        
+        memcpy(labeled + i, &fillWord, sizeof(fillWord));
+        while (newCells)
+        {
+            labels[i*8 + LowestBit(newCells)] = regionId;
+            newCells &= newCells - 1;
+        }
+    }
+    for (; i < deckBytes; ++i)
+    {
+        uint64 newCells = filled[i] & ~labeled[i];
+        labeled[i] = filled[i];
+        while (newCells)
+        {
+            labels[i*8 + LowestBit(newCells)] = regionId;
+            newCells &= newCells - 1;
+        }
+    }
+}
+
+int Flood_Batch(FloodContext* ctx, int algo, const uint8* bitdeck, int dim, uint8* filled, const FloodSeed* seeds, int numSeeds, int* regionIds)
+{
+    size_t deckBytes = ((size_t)dim*dim + 7)/8;
+    int* labels = FloodContextLabels(ctx, (size_t)dim*dim);
+    uint8* labeled = FloodContextLabeledCells(ctx, deckBytes);
+    memset(filled, 0, deckBytes);
+    memset(labeled, 0, deckBytes);
+    
+    int numRegions = 0;
+    for (int s = 0; s < numSeeds; ++s)
+    {
+        int seedX = seeds[s].X;
+        int seedY = seeds[s].Y;
+        regionIds[s] = -1;
+        if ((seedX < 0) | (seedX >= dim) | (seedY < 0) | (seedY >= dim)) continue;
+        
+        int cell = seedY*dim + seedX;
+        int bitmask = 1 << (cell&7);
+        if (!(bitdeck[cell >> 3] & bitmask)) continue;
+        
+        if (filled[cell >> 3] & bitmask)
+        {
+            regionIds[s] = labels[cell];
+            continue;
+        }
+        
+        Flood(ctx, algo, bitdeck, dim, filled, seedX, seedY);
+        LabelNewCells(filled, labeled, deckBytes, labels, numRegions);
+        regionIds[s] = numRegions++;
+    }
+    
+    return numRegions;
+}
+
+// 4 directional test with stack
+
+static inline int FillCell(const uint8* bitdeck, int dim, uint8* filled, int x, int y)
+{
+    // bitwise intentional to collapse to single branch
+    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
+    
+    int cell = y*dim + x;
+    int byte = cell >> 3;
+    uint8 bitmask = 1 << (cell&7);
+    if (((bitdeck[byte] & bitmask) != 0) &&
+        ((filled[byte] & bitmask) == 0))
+    {
+        filled[byte] |= bitmask;
+        return cell;
+    }
+    return -1;
+}
+
+static inline int FillCellTest(const uint8* bitdeck, int dim, uint8* filled, uint8* tested, int* testCount, int x, int y)
+{
+    // bitwise intentional to collapse to single branch
+    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
+    
+    int cell = y*dim + x;
+    int byte = cell >> 3;
+    uint8 bitmask = 1 << (cell&7);
+    tested[byte] |= bitmask;
+    (*testCount)++;
+    
+    if (((bitdeck[byte] & bitmask) != 0) &&
+        ((filled[byte] & bitmask) == 0))
+    {
+        filled[byte] |= bitmask;
+        return cell;
+    }
+    return -1;
+}
+
+int Flood_1(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    int* stack = FloodContextStack(ctx, (size_t)dim*dim); // Overkill for now
+    int stackCount = 0;
+    
+    // fill seed cell push on stack
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        stack[stackCount++] = cellIndex;
+    }
+    
+    int totalFilled = 0;
+    
+    // while something in stack
+    while (stackCount)
+    {
+        ++totalFilled;
+        
+        // pop stack,
+        cellIndex = stack[--stackCount];
+        
+        // for each of 4 directions, if bitdeck positive and not filled, fill cell, push on stack
+        seedY = cellIndex/dim;
+        seedX = cellIndex%dim;
+        
+        int left = FillCell(bitdeck, dim, filled, seedX, seedY-1);
+        int right = FillCell(bitdeck, dim, filled, seedX, seedY+1);
+        int up = FillCell(bitdeck, dim, filled, seedX-1, seedY);
+        int down = FillCell(bitdeck, dim, filled, seedX+1, seedY);
+        
+        if (left >= 0) stack[stackCount++] = left;
+        if (right >= 0) stack[stackCount++] = right;
+        if (up >= 0) stack[stackCount++] = up;
+        if (down >= 0) stack[stackCount++] = down;
+        
+        if (ctx->Connectivity == 8)
+        {
+            int upLeft = FillCell(bitdeck, dim, filled, seedX-1, seedY-1);
+            int upRight = FillCell(bitdeck, dim, filled, seedX+1, seedY-1);
+            int downLeft = FillCell(bitdeck, dim, filled, seedX-1, seedY+1);
+            int downRight = FillCell(bitdeck, dim, filled, seedX+1, seedY+1);
+            
+            if (upLeft >= 0) stack[stackCount++] = upLeft;
+            if (upRight >= 0) stack[stackCount++] = upRight;
+            if (downLeft >= 0) stack[stackCount++] = downLeft;
+            if (downRight >= 0) stack[stackCount++] = downRight;
+        }
+    }
+    
+    return totalFilled;
+}
+
+int Flood_1_Incremental_Start(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
+{
+    (void)ctx;
+    IncrementalState* isStack = (IncrementalState*)stack;
+    
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        IncrementalState newState;
+        memset(&newState, 0, sizeof(newState));
+        newState.Dfs.CellIndex = cellIndex;
+       
+        isStack[(*stackCount)++] = newState;
+        return *stackCount;
+    }
+    return 0;
+    
+}
+
+int Flood_1_Incremental(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
+{
+     // while something in stack
+    IncrementalState* isStack = (IncrementalState*)stack;
+    int sc = *stackCount;
+    int filledCount = 0;
+    int tc = 0;
+    
+    if (sc)
+    {
+        DFSSIState* state = &isStack[sc-1].Dfs;
+        bool eightWay = ctx->Connectivity == 8;
+        
+        int cellIndex = state->CellIndex;
+        
+        // for each of 4 directions, if bitdeck positive and not filled, fill cell, push on stack
+        int y = cellIndex/dim;
+        int x = cellIndex%dim;
+        
+        switch (state->Stage)
+        {        
+        case 0:
+        {
+            int top = FillCellTest(bitdeck, dim, filled, tested, &tc, x, y-1);
+            if (top >= 0)
+            {
+                filledCount++;
+                state->PushTop = true;
+            }
+            state->Stage++;
+            break;
+        }
+        case 1:
+        {
+            int bottom = FillCellTest(bitdeck, dim, filled, tested, &tc, x, y+1);
+            if (bottom >= 0)
+            {
+                filledCount++;
+                state->PushBottom = true;
+            }
+            state->Stage++;
+            break;
+        }
+        case 2:
+        {
+            int left = FillCellTest(bitdeck, dim, filled, tested, &tc, x-1, y);
+            if (left >= 0)
+            {
+                filledCount++;
+                state->PushLeft = true;
+            }
+            state->Stage++;
+            break;
+        }
+        case 3:
+        {
+            int right = FillCellTest(bitdeck, dim, filled, tested, &tc, x+1, y);
+            if (right >= 0)
+            {
+                filledCount++;
+                state->PushRight = true;
+            }
+            state->Stage++;
+            if (eightWay) break;
+           // Fallthrough
+        }
+        case 4:
+        {
+            // Diagonals, only with 8-connectivity
+            if (eightWay)
+            {
+                if (FillCellTest(bitdeck, dim, filled, tested, &tc, x-1, y-1) >= 0)
+                {
+                    filledCount++;
+                    state->PushTopLeft = true;
+                }
+                state->Stage++;
+                break;
+            }
+            // Fallthrough
+        }
+        case 5:
+        {
+            if (eightWay)
+            {
+                if (FillCellTest(bitdeck, dim, filled, tested, &tc, x+1, y-1) >= 0)
+                {
+                    filledCount++;
+                    state->PushTopRight = true;
+                }
+                state->Stage++;
+                break;
+            }
+            // Fallthrough
+        }
+        case 6:
+        {
+            if (eightWay)
+            {
+                if (FillCellTest(bitdeck, dim, filled, tested, &tc, x-1, y+1) >= 0)
+                {
+                    filledCount++;
+                    state->PushBottomLeft = true;
+                }
+                state->Stage++;
+                break;
+            }
+            // Fallthrough
+        }
+        case 7:
+        {
+            if (eightWay)
+            {
+                if (FillCellTest(bitdeck, dim, filled, tested, &tc, x+1, y+1) >= 0)
+                {
+                    filledCount++;
+                    state->PushBottomRight = true;
+                }
+            }
+            state->Stage++;
+            // Fallthrough
+        }
+        case 8:
+        {
+            DFSSIState oldState = *state;
+            
+            // Pop stack
+            --sc;
+            
+            IncrementalState newState;
+            memset(&newState, 0, sizeof(newState));
+         
+            if (oldState.PushTop)
+            {
+                newState.Dfs.CellIndex = (y-1)*dim + x;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushBottom)
+            {
+                newState.Dfs.CellIndex = (y+1)*dim + x;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushLeft)
+            {
+                newState.Dfs.CellIndex = y*dim + x-1;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushRight)
+            {
+                newState.Dfs.CellIndex = y*dim + x+1;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushTopLeft)
+            {
+                newState.Dfs.CellIndex = (y-1)*dim + x-1;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushTopRight)
+            {
+                newState.Dfs.CellIndex = (y-1)*dim + x+1;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushBottomLeft)
+            {
+                newState.Dfs.CellIndex = (y+1)*dim + x-1;
+                isStack[sc++] = newState;
+            }
+            if (oldState.PushBottomRight)
+            {
+                newState.Dfs.CellIndex = (y+1)*dim + x+1;
+                isStack[sc++] = newState;
+            }
+           
+        }
+        default:
+            break;
+        };
+
+      
+        *stackCount = sc;
+    }
+   
+   *numTested = tc;
+   return filledCount;
+}
+
+static inline int TestCell(const uint8* bitdeck, int dim, uint8* filled, int x, int y)
+{
+    // bitwise intentional to collapse to single branch
+    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
+    
+    int cell = y*dim + x;
+    int byte = cell >> 3;
+    uint8 bitmask = 1 << (cell&7);
+    if (((bitdeck[byte] & bitmask) != 0) &&
+        ((filled[byte] & bitmask) == 0))
+    {
+        return cell;
+    }
+    return -1;
+}
+
+static inline int TestCellTest(const uint8* bitdeck, int dim, uint8* filled, uint8* tested, int* testCount, int x, int y)
+{
+    // bitwise intentional to collapse to single branch
+    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return -1;
+    
+    int cell = y*dim + x;
+    int byte = cell >> 3;
+    uint8 bitmask = 1 << (cell&7);
+    
+    tested[byte] |= bitmask;
+    (*testCount)++;
+    
+    if (((bitdeck[byte] & bitmask) != 0) &&
+        ((filled[byte] & bitmask) == 0))
+    {
+        return cell;
+    }
+    return -1;
+}
+
+int Flood_2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    int* stack = FloodContextStack(ctx, (size_t)dim*dim); // This algo very stack efficient except in pathological worst case where up to dim*dim/2 could be required.
+    int stackCount = 0;
+    
+    // Test and add seed cell to stack
+    int cellIndex = seedY*dim + seedX;
+    int byte = cellIndex >> 3;
+    int bitmask = (1 << (cellIndex&7));
+    
+    if ((bitdeck[byte] & bitmask) != 0 &&
+        (filled[byte] & bitmask) == 0)
+    {
+        stack[stackCount++] = cellIndex;
+    }
+    
+    int numfilled = 0;
+    
+    // While something on stack
+    while(stackCount)
+    {    
+        // pop cell index, 
+        cellIndex = stack[--stackCount];
+        
+        int xleft, xright;
+        
+        // Span fill right
+        int inc = 1;
+        int y = cellIndex/dim;
+        int x = cellIndex%dim;
+       
+        while (0 <= FillCell(bitdeck, dim, filled, x, y))
+        {
+            x+=inc;
+            ++numfilled;
+        }
+        xright = x-inc;
+       
+        // span fill left
+        x = (cellIndex%dim)-1;
+        inc = -1;
+        while (0 <= FillCell(bitdeck, dim, filled, x, y))
+        {
+            x+=inc;
+             ++numfilled;
+        }
+        xleft = x-inc;
+        
+        // Diagonal neighbours reach one cell past either end of the span
+        if (ctx->Connectivity == 8)
+        {
+            --xleft;
+            ++xright;
+        }
+        
+        // Scan above for seed, push
+        if (y > 0)
+        {
+            x = xleft;
+            int prevSeed = -1;
+            while (x <= xright)
+            {
+                int newSeed = TestCell(bitdeck, dim, filled, x, y-1);
+                if (newSeed >= 0 && prevSeed == -1)
+                {
+                    stack[stackCount++] = newSeed;
+                }
+                prevSeed = newSeed;
+                ++x;
+            }
+        }
+        
+        // Scan below for seed, push
+        if (y < dim-1)
+        {
+            x = xleft;
+            int prevSeed = -1;
+            while (x <= xright)
+            {
+                int newSeed = TestCell(bitdeck, dim, filled, x, y+1);
+                if (newSeed >= 0 && prevSeed == -1)
+                {
+                    stack[stackCount++] = newSeed;
+                }
+                prevSeed = newSeed;
+                ++x;
+            }
+        }
+    }
+    
+    return numfilled;
+}
+
+int Flood_2_Incremental_Start(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
+{
+    (void)ctx;
+    IncrementalState* isStack = (IncrementalState*)stack;
+    
+    // Test and add seed cell to stack
+    int cellIndex = seedY*dim + seedX;
+    int byte = cellIndex >> 3;
+    int bitmask = (1 << (cellIndex&7));
+    
+    if ((bitdeck[byte] & bitmask) != 0 &&
+        (filled[byte] & bitmask) == 0)
+    {
+        IncrementalState newState;
+        memset(&newState, 0, sizeof(newState));
+        newState.Sf.CellIndex = cellIndex;
+        
+        isStack[(*stackCount)++] = newState;
+    }
+    
+    return 0;
+}
+
+int Flood_2_Incremental(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
+{
+    IncrementalState* isStack = (IncrementalState*)stack;
+    int numfilled = 0;
+    int tc = 0;
+    
+    // A span has at most dim cells, so one step can't find more than dim new seeds above and below
+    FloodContextSeedStack(ctx, dim + 2);
+    
+     // While something on stack
+    int sc = *stackCount;
+    if (sc)
+    {    
+        // pop cell index, 
+        SpanFillSIState* state = &isStack[sc-1].Sf;
+        int cellIndex = state->CellIndex;
+        int y = cellIndex/dim;
+        
+        switch (state->Stage)
+        {
+        case 0:
+        {
+            // Initialize
+            state->X = cellIndex%dim;
+            state->Stage++;
+            // fallthrough
+        }
+        case 1:
+        {
+            // Span fill right
+            int inc = 1;
+            if (0 <= FillCellTest(bitdeck, dim, filled, tested, &tc, state->X, y))
+            {
+                state->X+=inc;
+                ++numfilled;
+            }
+            else
+            {
+                state->xRight = state->X - inc;
+                state->X = (cellIndex%dim)-1;
+                state->Stage++;
+            }
+            break;
+        }
+        case 2:
+        {
+            // span fill left
+            int inc = -1;
+            if (0 <= FillCellTest(bitdeck, dim, filled, tested, &tc, state->X, y))
+            {
+                state->X+=inc;
+                 ++numfilled;
+            }
+            else
+            {
+                state->xLeft = state->X - inc;
+                
+                // Diagonal neighbours reach one cell past either end of the span
+                if (ctx->Connectivity == 8)
+                {
+                    state->xLeft--;
+                    state->xRight++;
+                }
+                state->X = state->xLeft;
+                state->PrevSeed = -1;
+                state->Stage++;
+            }
+            break;
+        }
+        case 3:
+        {
+            // Scan above for seed, push
+            if (y > 0)
+            {
+                if (state->X <= state->xRight)
+                {
+                    int newSeed = TestCellTest(bitdeck, dim, filled, tested, &tc, state->X, y-1);
+                    if (newSeed >= 0 && state->PrevSeed == -1)
+                    {
+                        ctx->SeedStack[ctx->SeedStackCount++] = newSeed;
+                        state->PushCount++;
+                    }
+                    state->PrevSeed = newSeed;
+                    state->X++;
+                    break;
+                }
+               
+            }
+            
+            state->X = state->xLeft;
+            state->PrevSeed = -1;
+            state->Stage++;
+            // fallthrough;
+            
+        }
+        case 4:
+        {
+            // Scan below for seed, push
+            if (y < dim-1)
+            {
+                if (state->X <= state->xRight)
+                {
+                    int newSeed = TestCellTest(bitdeck, dim, filled, tested, &tc, state->X, y+1);
+                    if (newSeed >= 0 && state->PrevSeed == -1)
+                    {
+                        ctx->SeedStack[ctx->SeedStackCount++] = newSeed;
+                        state->PushCount++;
+                    }
+                    state->PrevSeed = newSeed;
+                    state->X++;
+                    break;
+                }
+            }
+            state->Stage++;
+            // fallthrough
+        }
+        case 5:
+        {
+            // Resolve stack
+            int pushCount = state->PushCount;
+             --sc;
+            while (pushCount)
+            {
+                IncrementalState newState;
+                memset(&newState, 0, sizeof(newState));
+                
+                newState.Sf.CellIndex = ctx->SeedStack[--ctx->SeedStackCount];
+                isStack[sc++] = newState;
+                
+                --pushCount;
+            }
+            
+        }
+        
+        };
+    }
+    
+    *numTested = tc;
+    *stackCount = sc;
+    return numfilled;
+}
+
+
+int Flood_3(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    // This algorithm is optimized for grids of 64 bits per line, but wider lines can be accomodated
+    // by treating the overall grid as a grid of lines and adding cases for the horizontal neighbor tests.
+    
+    // Since we do full row operations, we cannot stack multiple discovered spans from the same row. We'll
+    // stack an entire row, and there are only two directions we can look for new work in, up and down.
+    // We'll prefer the down direction, so the stack size increases only when there is newly discovered
+    // work in the upward direction that we leave behind as we push downward. Therefore, we can't possibly
+    // push more than 'dim' rows to the stack, as that would imply we pushed more than one row per row
+    // we traversed. In fact, since we must scan at least two cells horizontally to discover a new vertical
+    // span, as we traverse the entire grid, we can't have pushed more than dim/2 rows to the stack, where
+    // dim is the longest dimension. I've generated this test case in the provided worst-case fill pattern,
+    // which will cause this algorithm to stack exactly 32 entries for a 64x64 grid if the fill is started
+    // from either top corner.
+    
+    // The dim/2 argument doesn't hold once a row can be re-discovered from both sides before it is popped
+    // again, which random decks do readily (the benchmark measured 42 entries on 64x64). A row that is
+    // already waiting on the stack will see any newly filled bits when it's popped, so we never stack it
+    // twice, and the stack can't hold more than 'dim' rows.
+    
+    int* stack = FloodContextStack(ctx, dim); 
+    int stackCount = 0;
+    uint64 stackedRows = 0;
+    int numFilled = 0;
+    
+    // Test and add seed cell to stack    
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        // We stack row numbers, not cell numbers
+        stack[stackCount++] = cellIndex/64;
+        stackedRows |= 1llu << (cellIndex/64);
+        ++numFilled;
+    }
+    
+    uint64* bitRows = (uint64*)bitdeck;
+    uint64* fillRows = (uint64*)filled;
+    uint64 diagonals = FloodDiagonals(ctx);
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows &= ~(1llu << rowIndex);
+        
+        uint64 bitRow = bitRows[rowIndex];
+        uint64 fillRow = fillRows[rowIndex];
+        uint64 fillRowStart = fillRow;
+        uint64 test = (fillRow<<1)&bitRow;
+        uint64 fillRowPrev = 0;
+        
+        // Simulscan fill left
+        while (test && (fillRowPrev != fillRow))
+        {
+            fillRowPrev = fillRow;
+            fillRow |= test;
+            test <<= 1;
+            test &= bitRow;
+        }
+        
+        // Simulscan fill right
+        fillRowPrev = 0;
+        test = (fillRow>>1)&bitRow;
+        while (test && (fillRowPrev != fillRow))
+        {
+            fillRowPrev = fillRow;
+            fillRow |= test;
+            test >>= 1;
+            test &= bitRow;
+        }
+        
+        fillRows[rowIndex] = fillRow;
+        numFilled += CountBits(fillRow ^ fillRowStart);
+        
+        // With 8-connectivity the row also reaches one cell diagonally either side
+        uint64 reach = ReachRow(fillRow, diagonals);
+        
+        // Bitfill up
+        if (rowIndex > 0)
+        {
+            uint64 oldFill = fillRows[rowIndex-1];
+            uint64 newFill = oldFill | (reach & bitRows[rowIndex-1]);
+            if (oldFill != newFill)
+            {
+                fillRows[rowIndex-1] = newFill;
+                if (!(stackedRows & (1llu << (rowIndex-1))))
+                {
+                    stackedRows |= 1llu << (rowIndex-1);
+                    stack[stackCount++] = rowIndex-1;
+                }
+                numFilled += CountBits(oldFill ^ newFill);
+            }
+        }
+        
+        // Bitfill down
+        if (rowIndex < dim-1)
+        {
+            uint64 oldFill = fillRows[rowIndex+1];
+            uint64 newFill = oldFill | (reach & bitRows[rowIndex+1]);
+            if (oldFill != newFill)
+            {
+                fillRows[rowIndex+1] = newFill;
+                if (!(stackedRows & (1llu << (rowIndex+1))))
+                {
+                    stackedRows |= 1llu << (rowIndex+1);
+                    stack[stackCount++] = rowIndex+1;
+                }
+                numFilled += CountBits(oldFill ^ newFill);
+            }
+        }
+    }
+    
+    return numFilled;
+}
+
+
+int Flood_3_Incremental_Start(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, int seedX, int seedY)
+{
+    (void)ctx;
+     // Fill seed cell and stack its row
+     SimulSpanFillSIState* siStack = (SimulSpanFillSIState*)stack;
+     
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        // We stack row numbers, not cell numbers
+        SimulSpanFillSIState newState;
+        memset(&newState, 0, sizeof(newState));
+        
+        newState.RowIndex = cellIndex/64;
+        
+        siStack[(*stackCount)++] = newState;
+        return 1;
+    }
+    
+    return 0;
+}
+
+
+int Flood_3_Incremental(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int* stack, int* stackCount, uint8* tested, int* numTested)
+{
+    IncrementalState* siStack = (IncrementalState*)stack;
+    uint64* bitRows = (uint64*)bitdeck;
+    uint64* fillRows = (uint64*)filled;
+    uint64* testRows = (uint64*)tested;
+    uint64 diagonals = FloodDiagonals(ctx);
+    
+    int sc = *stackCount;
+    int numFilled = 0;
+    int testCount = 0;
+    
+    if (sc)
+    {
+        SimulSpanFillSIState* state = &siStack[sc-1].Ssf;
+        int rowIndex = state->RowIndex;
+        
+        uint64 bitRow = bitRows[rowIndex];
+        uint64 fillRow = fillRows[rowIndex];
+            
+        switch (state->Stage)
+        {
+            case 0:
+            {
+                state->FillRowPrev = 0;
+                state->Test = (fillRow<<1)&bitRow;
+                testCount++;
+                
+                state->Stage++;
+                // Fallthrough
+            }
+            case 1:
+            {                
+                // Simulscan fill left
+                if (state->Test)
+                {
+                    uint64 fillRowPrev = fillRow;
+                    fillRow |= state->Test;
+                    state->Test <<= 1;
+                    state->Test &= bitRow;
+                    
+                    if (fillRowPrev != fillRow)
+                    {
+                        fillRows[rowIndex] = fillRow;
+                        
+                        uint64 newFilled = fillRow ^ fillRowPrev;
+                        testRows[rowIndex] = newFilled;
+                        numFilled += CountBits(newFilled);
+                        break;
+                    }
+                }
+                
+                state->FillRowPrev = 0;
+                state->Test = (fillRow>>1)&bitRow;
+                
+                state->Stage++;
+                // Fallthrough
+            }
+            case 2:
+            {
+                // Simulscan fill right
+                if (state->Test)
+                {
+                    uint64 fillRowPrev = fillRow;
+                    fillRow |= state->Test;
+                    state->Test >>= 1;
+                    state->Test &= bitRow;
+                    if (fillRowPrev != fillRow)
+                    {
+                        fillRows[rowIndex] = fillRow;
+                        
+                        uint64 newFilled = fillRow ^ fillRowPrev;
+                        testRows[rowIndex] = newFilled;
+                        numFilled += CountBits(newFilled);
+                        break;
+                    }
+                }
+                state->Stage++;
+                // Fallthrough
+            }
+            case 3:
+            {     
+                // Bitfill up
+                if (rowIndex > 0)
+                {
+                    testCount++;
+                    uint64 reach = ReachRow(fillRow, diagonals);
+                    testRows[rowIndex-1] |= reach;
+                    
+                    uint64 oldFill = fillRows[rowIndex-1];
+                    uint64 newFill = oldFill | (reach & bitRows[rowIndex-1]);
+                    if (oldFill != newFill)
+                    {
+                        fillRows[rowIndex-1] = newFill;
+                        state->PushNextAbove = true;
+                        
+                        // Count how many we filled
+                        numFilled += CountBits(oldFill ^ newFill);
+                        state->Stage++;
+                        break;
+                    }
+
+                }
+                state->Stage++;
+                // Fallthrough
+            }
+            case 4:
+            {
+            
+                // Bitfill down
+                if (rowIndex < dim-1)
+                {
+                    testCount++;
+                    uint64 reach = ReachRow(fillRow, diagonals);
+                    testRows[rowIndex+1] |= reach;
+                    
+                    uint64 oldFill = fillRows[rowIndex+1];
+                    uint64 newFill = oldFill | (reach & bitRows[rowIndex+1]);
+                    if (oldFill != newFill)
+                    {
+                        fillRows[rowIndex+1] = newFill;
+                        state->PushNextBelow = true;
+                        
+                         // Count how many we filled
+                        numFilled += CountBits(oldFill ^ newFill);
+                    }
+                }
+                
+                // Pop existing state, push new ones on
+                
+                // Can't read existing state after decrement and push of a new state.
+                // Cache what we need.
+                bool pushNextAbove = state->PushNextAbove;
+                bool pushNextBelow = state->PushNextBelow;
+                --sc;
+                
+                IncrementalState newState;
+                memset(&newState, 0, sizeof(newState));
+                if (pushNextAbove)
+                {
+                    newState.Ssf.RowIndex = rowIndex-1;
+                    siStack[sc++] = newState;
+                }
+                if (pushNextBelow)
+                {
+                    newState.Ssf.RowIndex = rowIndex+1;
+                    siStack[sc++] = newState;
+                }
+            }
+            default:
+                break;  
+        }
+    }
+    
+    *numTested = testCount;
+    *stackCount = sc;
+    
+    return numFilled;
+}
+
+
+// Multi-word rows
+
+// Written so a plane file's width can be anything up to INT_MAX
+static inline int RowWords(int dim)
+{
+    return dim/64 + (dim%64 != 0);
+}
+
+// Reads up to 64 bits starting at any bit of a packed deck.
+static uint64 LoadBits(const uint8* deck, size_t bitIndex, int numBits)
+{
+    uint64 value = 0;
+    int loaded = 0;
+    while (loaded < numBits)
+    {
+        int shift = bitIndex & 7;
+        int count = (8 - shift) < (numBits - loaded) ? (8 - shift) : (numBits - loaded);
+        value |= (uint64)((deck[bitIndex >> 3] >> shift) & ((1u << count) - 1)) << loaded;
+        loaded += count;
+        bitIndex += count;
+    }
+    return value;
+}
+
+// Writes up to 64 bits starting at any bit of a packed deck, leaving the surrounding bits alone.
+static void StoreBits(uint8* deck, size_t bitIndex, int numBits, uint64 value)
+{
+    while (numBits > 0)
+    {
+        int shift = bitIndex & 7;
+        int count = (8 - shift) < numBits ? (8 - shift) : numBits;
+        uint8 mask = (uint8)(((1u << count) - 1) << shift);
+        deck[bitIndex >> 3] = (deck[bitIndex >> 3] & ~mask) | ((uint8)(value << shift) & mask);
+        value >>= count;
+        bitIndex += count;
+        numBits -= count;
+    }
+}
+
+// Copies a packed dim*dim deck into rows of whole 64 bit words. The padding bits past 'dim' are left
+// clear, so they can never fill, and the row operations need no masking.
+static void PadRows(const uint8* deck, int dim, uint64* rows)
+{
+    int rowWords = RowWords(dim);
+    for (int y = 0; y < dim; ++y)
+    {
+        for (int w = 0; w < rowWords; ++w)
+        {
+            int numBits = (dim - w*64) < 64 ? (dim - w*64) : 64;
+            rows[y*rowWords + w] = LoadBits(deck, (size_t)y*dim + w*64, numBits);
+        }
+    }
+}
+
+static void UnpadRows(const uint64* rows, int dim, uint8* deck)
+{
+    int rowWords = RowWords(dim);
+    for (int y = 0; y < dim; ++y)
+    {
+        for (int w = 0; w < rowWords; ++w)
+        {
+            int numBits = (dim - w*64) < 64 ? (dim - w*64) : 64;
+            StoreBits(deck, (size_t)y*dim + w*64, numBits, rows[y*rowWords + w]);
+        }
+    }
+}
+
+// Sum of x*x for x = 0..n
+static FORCE_INLINE uint64 SumOfSquares(int64 n)
+{
+    return n < 0 ? 0 : (uint64)(n*(n + 1)*(2*n + 1)/6);
+}
+
+// Adds the cells set in one word of row y, the word starting at column x0. Newly filled bits are mostly
+// a few runs, whose sums of x and x*x are taken in closed form with the run ends found by tzcnt. Words
+// broken into many runs use weighted popcounts instead: sum x is the count of bits whose index has bit
+// j set, times 2^j, summed over j, and sum x*x adds the pairs of index bits j, k at 2^(j+k).
+static FORCE_INLINE void AddWordStats(FloodStats* stats, uint64 bits, int x0, int y)
+{
+    static const uint64 indexBits[6] =
+    {
+        0xaaaaaaaaaaaaaaaallu, 0xccccccccccccccccllu, 0xf0f0f0f0f0f0f0f0llu,
+        0xff00ff00ff00ff00llu, 0xffff0000ffff0000llu, 0xffffffff00000000llu,
+    };
+    
+    if (!bits) return;
+    
+    uint64 count = 0;
+    uint64 sumX = 0;
+    uint64 sumXX = 0;
+    int minX = x0 + LowestBit(bits);
+    int maxX = x0 + HighestBit(bits);
+    
+    if (CountBits(bits & ~(bits << 1)) <= 4)
+    {
+        while (bits)
+        {
+            int first = LowestBit(bits);
+            uint64 rest = ~bits & (~0llu << first);
+            int last = rest ? LowestBit(rest) - 1 : 63;
+            bits = last < 63 ? bits & (~0llu << (last + 1)) : 0;
+            
+            int64 a = x0 + first;
+            int64 b = x0 + last;
+            count += b - a + 1;
+            sumX += (uint64)((a + b)*(b - a + 1)/2);
+            sumXX += SumOfSquares(b) - SumOfSquares(a - 1);
+        }
+    }
+    else
+    {
+        uint64 localX = 0;
+        uint64 localXX = 0;
+        for (int j = 0; j < 6; ++j)
+        {
+            uint64 bitsJ = bits & indexBits[j];
+            uint64 countJ = CountBits(bitsJ);
+            localX += countJ << j;
+            localXX += countJ << (2*j);
+            for (int k = j+1; k < 6; ++k)
+            {
+                localXX += CountBits(bitsJ & indexBits[k]) << (j + k + 1);
+            }
+        }
+        
+        // Move the local sums over to the word's column
+        uint64 x = (uint64)x0;
+        count = CountBits(bits);
+        sumX = count*x + localX;
+        sumXX = count*x*x + 2*x*localX + localXX;
+    }
+    
+    stats->Area += count;
+    stats->SumX += sumX;
+    stats->SumXX += sumXX;
+    stats->SumY += count*y;
+    stats->SumYY += count*y*y;
+    stats->SumXY += sumX*y;
+    
+    if (minX < stats->MinX) stats->MinX = minX;
+    if (maxX > stats->MaxX) stats->MaxX = maxX;
+    if (y < stats->MinY) stats->MinY = y;
+    if (y > stats->MaxY) stats->MaxY = y;
+}
+
+// Rows a fill has changed, each kept as it was before its first change, so stats can be taken once per
+// row from the newly filled bits after the fill rather than every time a row gains some.
+typedef struct
+{
+    uint64* Rows;               // One bit per row
+    uint64* StartRows;          // Row major, only written for marked rows
+} FloodTouchedRows;
+
+// Marks a row the fill is about to change, keeping its words the first time
+static FORCE_INLINE void TouchRow(FloodTouchedRows* touched, const uint64* fillRow, int rowWords, int y)
+{
+    uint64 rowBit = 1llu << (y%64);
+    if (touched->Rows[y/64] & rowBit) return;
+    
+    touched->Rows[y/64] |= rowBit;
+    uint64* startRow = touched->StartRows + (size_t)y*rowWords;
+    for (int w = 0; w < rowWords; ++w)
+    {
+        startRow[w] = fillRow[w];
+    }
+}
+
+// Adds the bits the fill set in the touched rows, one AddWordStats per changed word
+static FORCE_INLINE void AddTouchedRowStats(FloodStats* stats, const FloodTouchedRows* touched, const uint64* fillRows, int dim)
+{
+    int rowWords = RowWords(dim);
+    for (int i = 0; i < rowWords; ++i)
+    {
+        for (uint64 rows = touched->Rows[i]; rows; rows &= rows - 1)
+        {
+            int y = i*64 + LowestBit(rows);
+            for (int w = 0; w < rowWords; ++w)
+            {
+                size_t word = (size_t)y*rowWords + w;
+                AddWordStats(stats, fillRows[word] ^ touched->StartRows[word], w*64, y);
+            }
+        }
+    }
+}
+
+// Simulscan fills every span of a multi-word row that already holds a filled bit. The left pass walks
+// the words upward and the right pass walks them back down, each carrying its edge bit into the next
+// word, so spans crossing any number of words are completed in one pass each way. 'clipRow' (may be
+// null) is ANDed into the bits as they're loaded. Returns the number of newly filled bits.
+static FORCE_INLINE int SimulScanRow(const uint64* bitRow, const uint64* clipRow, uint64* fillRow, int rowWords)
+{
+    int countBefore = 0;
+    int countAfter = 0;
+    
+    // Simulscan fill left
+    uint64 carry = 0;
+    for (int w = 0; w < rowWords; ++w)
+    {
+        uint64 bits = clipRow ? bitRow[w] & clipRow[w] : bitRow[w];
+        uint64 fill = fillRow[w];
+        countBefore += CountBits(fill);
+        
+        uint64 test = ((fill<<1) | carry) & bits;
+        while (test & ~fill)
+        {
+            fill |= test;
+            test <<= 1;
+            test &= bits;
+        }
+        
+        fillRow[w] = fill;
+        carry = fill >> 63;
+    }
+    
+    // Simulscan fill right
+    carry = 0;
+    for (int w = rowWords-1; w >= 0; --w)
+    {
+        uint64 bits = clipRow ? bitRow[w] & clipRow[w] : bitRow[w];
+        uint64 fill = fillRow[w];
+        
+        uint64 test = ((fill>>1) | (carry<<63)) & bits;
+        while (test & ~fill)
+        {
+            fill |= test;
+            test >>= 1;
+            test &= bits;
+        }
+        
+        fillRow[w] = fill;
+        countAfter += CountBits(fill);
+        carry = fill & 1;
+    }
+    
+    return countAfter - countBefore;
+}
+
+// Bitfills a neighbouring row from a filled row, diagonally too when 'diagonals' is all ones. The
+// sideways reach borrows the edge bits of the neighbouring words. 'clipRowNext' (may be null) is ANDed
+// into the neighbouring row's bits. 'touched' (may be null) notes the neighbouring row, yNext, before it
+// first changes. Returns the number of newly filled bits.
+static FORCE_INLINE int SimulFillRow(const uint64* fillRow, const uint64* bitRowNext, const uint64* clipRowNext, uint64* fillRowNext, int rowWords, uint64 diagonals, FloodTouchedRows* touched, int yNext)
+{
+    int numFilled = 0;
+    for (int w = 0; w < rowWords; ++w)
+    {
+        uint64 reach = fillRow[w];
+        if (diagonals)
+        {
+            uint64 fromLeft = w > 0 ? fillRow[w-1] >> 63 : 0;
+            uint64 fromRight = w < rowWords-1 ? fillRow[w+1] << 63 : 0;
+            reach |= (reach << 1) | (reach >> 1) | fromLeft | fromRight;
+        }
+        
+        if (clipRowNext) reach &= clipRowNext[w];
+        
+        uint64 oldFill = fillRowNext[w];
+        uint64 newFill = oldFill | (reach & bitRowNext[w]);
+        if (oldFill != newFill)
+        {
+            if (touched) TouchRow(touched, fillRowNext, rowWords, yNext);
+            fillRowNext[w] = newFill;
+            numFilled += CountBits(oldFill ^ newFill);
+        }
+    }
+    return numFilled;
+}
+
+// Runs the row stack of Flood_3 over rows 'rowWords' words long until nothing changes. Rows on the stack
+// must already be marked in stackedRows, which is 'rowWords' words of flags. clipRows (may be null) is
+// ANDed into bitRows as each row is loaded. touched (may be null) notes the rows the stack changes.
+// Returns the number of newly filled bits.
+static FORCE_INLINE int SimulSpanFillStack(const uint64* bitRows, const uint64* clipRows, uint64* fillRows, int dim, int* stack, int stackCount, uint64* stackedRows, uint64 diagonals, FloodTouchedRows* touched)
+{
+    int rowWords = RowWords(dim);
+    int numFilled = 0;
+    
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows[rowIndex/64] &= ~(1llu << (rowIndex%64));
+        
+        uint64* fillRow = fillRows + (size_t)rowIndex*rowWords;
+        numFilled += SimulScanRow(bitRows + (size_t)rowIndex*rowWords, clipRows ? clipRows + (size_t)rowIndex*rowWords : 0, fillRow, rowWords);
+        
+        // Bitfill up
+        if (rowIndex > 0)
+        {
+            int rowNext = rowIndex-1;
+            int rowFilled = SimulFillRow(fillRow, bitRows + (size_t)rowNext*rowWords, clipRows ? clipRows + (size_t)rowNext*rowWords : 0, fillRows + (size_t)rowNext*rowWords, rowWords, diagonals, touched, rowNext);
+            if (rowFilled && !(stackedRows[rowNext/64] & (1llu << (rowNext%64))))
+            {
+                stackedRows[rowNext/64] |= 1llu << (rowNext%64);
+                stack[stackCount++] = rowNext;
+            }
+            numFilled += rowFilled;
+        }
+        
+        // Bitfill down
+        if (rowIndex < dim-1)
+        {
+            int rowNext = rowIndex+1;
+            int rowFilled = SimulFillRow(fillRow, bitRows + (size_t)rowNext*rowWords, clipRows ? clipRows + (size_t)rowNext*rowWords : 0, fillRows + (size_t)rowNext*rowWords, rowWords, diagonals, touched, rowNext);
+            if (rowFilled && !(stackedRows[rowNext/64] & (1llu << (rowNext%64))))
+            {
+                stackedRows[rowNext/64] |= 1llu << (rowNext%64);
+                stack[stackCount++] = rowNext;
+            }
+            numFilled += rowFilled;
+        }
+    }
+    
+    return numFilled;
+}
+
+static FORCE_INLINE int SimulSpanFillRows(FloodContext* ctx, const uint64* bitRows, uint64* fillRows, int dim, int seedX, int seedY)
+{
+    // Same row stacking scheme as Flood_3, with each row 'rowWords' words long. Rows already waiting on
+    // the stack aren't stacked again, so the stack is bounded by 'dim' rows.
+    
+    if ((seedX < 0) | (seedX >= dim) | (seedY < 0) | (seedY >= dim)) return 0;
+    
+    int rowWords = RowWords(dim);
+    int* stack = FloodContextStack(ctx, dim);
+    int stackCount = 0;
+    uint64* stackedRows = FloodContextRowFlags(ctx, rowWords);
+    memset(stackedRows, 0, sizeof(uint64)*rowWords);
+    int numFilled = 0;
+    
+    // Test and add seed cell to stack
+    int seedWord = seedY*rowWords + seedX/64;
+    uint64 seedBit = 1llu << (seedX%64);
+    if ((bitRows[seedWord] & seedBit) && !(fillRows[seedWord] & seedBit))
+    {
+        fillRows[seedWord] |= seedBit;
+        stack[stackCount++] = seedY;
+        stackedRows[seedY/64] |= 1llu << (seedY%64);
+        ++numFilled;
+    }
+    
+    return numFilled + SimulSpanFillStack(bitRows, 0, fillRows, dim, stack, stackCount, stackedRows, FloodDiagonals(ctx), 0);
+}
+
+static FORCE_INLINE int MultiWordSimulSpanFill(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    // When dim is a multiple of 64 the packed deck is already laid out as whole words per row.
+    if (dim % 64 == 0)
+    {
+        return SimulSpanFillRows(ctx, (const uint64*)bitdeck, (uint64*)filled, dim, seedX, seedY);
+    }
+    
+    // Otherwise pad each row out to whole words in a working copy.
+    size_t rowsWords = (size_t)RowWords(dim)*dim;
+    uint64* bitRows = FloodContextRows(ctx, 2*rowsWords);
+    uint64* fillRows = bitRows + rowsWords;
+    PadRows(bitdeck, dim, bitRows);
+    PadRows(filled, dim, fillRows);
+    
+    int numFilled = SimulSpanFillRows(ctx, bitRows, fillRows, dim, seedX, seedY);
+    
+    UnpadRows(fillRows, dim, filled);
+    
+    return numFilled;
+}
+
+int Flood_4(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return MultiWordSimulSpanFill(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+
+// Register rows
+//
+// For 128 and 256 wide planes a whole row fits in one SSE or AVX2 register. The simulscan loops shift the
+// row one bit at a time like Flood_3, with the bit crossing each 64 bit lane carried in from its neighbour,
+// and the up and down bitfills are one AND/OR per row.
+
+static FORCE_INLINE __m128i ShiftLeft128(__m128i v)
+{
+    __m128i carry = _mm_srli_epi64(_mm_slli_si128(v, 8), 63);
+    return _mm_or_si128(_mm_slli_epi64(v, 1), carry);
+}
+
+static FORCE_INLINE __m128i ShiftRight128(__m128i v)
+{
+    __m128i carry = _mm_slli_epi64(_mm_srli_si128(v, 8), 63);
+    return _mm_or_si128(_mm_srli_epi64(v, 1), carry);
+}
+
+static FORCE_INLINE bool AnyBits128(__m128i v)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xffff;
+}
+
+static FORCE_INLINE int CountBits128(__m128i v)
+{
+    uint64 lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, v);
+    return CountBits(lanes[0]) + CountBits(lanes[1]);
+}
+
+// 'clip' (may be null) is ANDed into the rows as they're loaded, the seed is taken to be inside it.
+// 'touched' (may be null) notes the rows the fill changes, the seed must then be on the plane.
+static FORCE_INLINE int ClippedSimulSpanFill128(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY, FloodTouchedRows* touched)
+{
+    int stack[128];
+    int stackCount = 0;
+    uint64 stackedRows[2] = { 0, 0 };
+    int numFilled = 0;
+    
+    // Test and add seed cell to stack
+    if (touched) TouchRow(touched, (const uint64*)filled + seedY*2, 2, seedY);
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        stack[stackCount++] = cellIndex/128;
+        stackedRows[cellIndex/128/64] |= 1llu << ((cellIndex/128)%64);
+        ++numFilled;
+    }
+    
+    const __m128i* bitRows = (const __m128i*)bitdeck;
+    const __m128i* clipRows = (const __m128i*)clip;
+    __m128i* fillRows = (__m128i*)filled;
+    __m128i diagonals = _mm_set1_epi64x((long long)FloodDiagonals(ctx));
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows[rowIndex/64] &= ~(1llu << (rowIndex%64));
+        
+        __m128i bitRow = _mm_loadu_si128(&bitRows[rowIndex]);
+        if (clip) bitRow = _mm_and_si128(bitRow, _mm_loadu_si128(&clipRows[rowIndex]));
+        __m128i fillRow = _mm_loadu_si128(&fillRows[rowIndex]);
+        __m128i fillRowStart = fillRow;
+        
+        // Simulscan fill left
+        __m128i test = _mm_and_si128(ShiftLeft128(fillRow), bitRow);
+        while (AnyBits128(_mm_andnot_si128(fillRow, test)))
+        {
+            fillRow = _mm_or_si128(fillRow, test);
+            test = _mm_and_si128(ShiftLeft128(test), bitRow);
+        }
+        
+        // Simulscan fill right
+        test = _mm_and_si128(ShiftRight128(fillRow), bitRow);
+        while (AnyBits128(_mm_andnot_si128(fillRow, test)))
+        {
+            fillRow = _mm_or_si128(fillRow, test);
+            test = _mm_and_si128(ShiftRight128(test), bitRow);
+        }
+        
+        _mm_storeu_si128(&fillRows[rowIndex], fillRow);
+        numFilled += CountBits128(_mm_xor_si128(fillRow, fillRowStart));
+        
+        // Cells the row reaches in its neighbours, widened by one either side with 8-connectivity
+        __m128i reach = _mm_or_si128(fillRow, _mm_and_si128(_mm_or_si128(ShiftLeft128(fillRow), ShiftRight128(fillRow)), diagonals));
+        
+        for (int rowNext = rowIndex-1; rowNext <= rowIndex+1; rowNext += 2)
+        {
+            // Bitfill up, then down
+            if ((rowNext < 0) | (rowNext >= dim)) continue;
+            
+            __m128i oldFill = _mm_loadu_si128(&fillRows[rowNext]);
+            __m128i newBits = _mm_andnot_si128(oldFill, _mm_and_si128(reach, _mm_loadu_si128(&bitRows[rowNext])));
+            if (clip) newBits = _mm_and_si128(newBits, _mm_loadu_si128(&clipRows[rowNext]));
+            if (AnyBits128(newBits))
+            {
+                if (touched) TouchRow(touched, (const uint64*)&fillRows[rowNext], 2, rowNext);
+                _mm_storeu_si128(&fillRows[rowNext], _mm_or_si128(oldFill, newBits));
+                if (!(stackedRows[rowNext/64] & (1llu << (rowNext%64))))
+                {
+                    stackedRows[rowNext/64] |= 1llu << (rowNext%64);
+                    stack[stackCount++] = rowNext;
+                }
+                numFilled += CountBits128(newBits);
+            }
+        }
+    }
+    
+    return numFilled;
+}
+
+static FORCE_INLINE int SimulSpanFill128(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return ClippedSimulSpanFill128(ctx, bitdeck, 0, dim, filled, seedX, seedY, 0);
+}
+
+int Flood_5(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    if (dim != 128) return Flood_4(ctx, bitdeck, dim, filled, seedX, seedY);
+    
+    return SimulSpanFill128(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i ShiftLeft256(__m256i v)
+{
+    // Top bit of each lane moves to bit 0 of the lane above
+    __m256i carry = _mm256_permute4x64_epi64(_mm256_srli_epi64(v, 63), _MM_SHUFFLE(2, 1, 0, 3));
+    carry = _mm256_blend_epi32(carry, _mm256_setzero_si256(), 0x03);
+    return _mm256_or_si256(_mm256_slli_epi64(v, 1), carry);
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i ShiftRight256(__m256i v)
+{
+    // Bit 0 of each lane moves to the top bit of the lane below
+    __m256i carry = _mm256_permute4x64_epi64(_mm256_slli_epi64(v, 63), _MM_SHUFFLE(0, 3, 2, 1));
+    carry = _mm256_blend_epi32(carry, _mm256_setzero_si256(), 0xc0);
+    return _mm256_or_si256(_mm256_srli_epi64(v, 1), carry);
+}
+
+TARGET_AVX2 static FORCE_INLINE int CountBits256(__m256i v)
+{
+    uint64 lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, v);
+    return CountBits(lanes[0]) + CountBits(lanes[1]) + CountBits(lanes[2]) + CountBits(lanes[3]);
+}
+
+// 'clip' (may be null) is ANDed into the rows as they're loaded, the seed is taken to be inside it.
+// 'touched' (may be null) notes the rows the fill changes, the seed must then be on the plane.
+TARGET_AVX2 static FORCE_INLINE int ClippedSimulSpanFill256(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY, FloodTouchedRows* touched)
+{
+    int stack[256];
+    int stackCount = 0;
+    uint64 stackedRows[4] = { 0, 0, 0, 0 };
+    int numFilled = 0;
+    
+    // Test and add seed cell to stack
+    if (touched) TouchRow(touched, (const uint64*)filled + seedY*4, 4, seedY);
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        stack[stackCount++] = cellIndex/256;
+        stackedRows[cellIndex/256/64] |= 1llu << ((cellIndex/256)%64);
+        ++numFilled;
+    }
+    
+    const __m256i* bitRows = (const __m256i*)bitdeck;
+    const __m256i* clipRows = (const __m256i*)clip;
+    __m256i* fillRows = (__m256i*)filled;
+    __m256i diagonals = _mm256_set1_epi64x((long long)FloodDiagonals(ctx));
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows[rowIndex/64] &= ~(1llu << (rowIndex%64));
+        
+        __m256i bitRow = _mm256_loadu_si256(&bitRows[rowIndex]);
+        if (clip) bitRow = _mm256_and_si256(bitRow, _mm256_loadu_si256(&clipRows[rowIndex]));
+        __m256i fillRow = _mm256_loadu_si256(&fillRows[rowIndex]);
+        __m256i fillRowStart = fillRow;
+        
+        // Simulscan fill left, testc is set when test holds nothing that isn't already filled
+        __m256i test = _mm256_and_si256(ShiftLeft256(fillRow), bitRow);
+        while (!_mm256_testc_si256(fillRow, test))
+        {
+            fillRow = _mm256_or_si256(fillRow, test);
+            test = _mm256_and_si256(ShiftLeft256(test), bitRow);
+        }
+        
+        // Simulscan fill right
+        test = _mm256_and_si256(ShiftRight256(fillRow), bitRow);
+        while (!_mm256_testc_si256(fillRow, test))
+        {
+            fillRow = _mm256_or_si256(fillRow, test);
+            test = _mm256_and_si256(ShiftRight256(test), bitRow);
+        }
+        
+        _mm256_storeu_si256(&fillRows[rowIndex], fillRow);
+        numFilled += CountBits256(_mm256_xor_si256(fillRow, fillRowStart));
+        
+        // Cells the row reaches in its neighbours, widened by one either side with 8-connectivity
+        __m256i reach = _mm256_or_si256(fillRow, _mm256_and_si256(_mm256_or_si256(ShiftLeft256(fillRow), ShiftRight256(fillRow)), diagonals));
+        
+        for (int rowNext = rowIndex-1; rowNext <= rowIndex+1; rowNext += 2)
+        {
+            // Bitfill up, then down
+            if ((rowNext < 0) | (rowNext >= dim)) continue;
+            
+            __m256i oldFill = _mm256_loadu_si256(&fillRows[rowNext]);
+            __m256i newBits = _mm256_andnot_si256(oldFill, _mm256_and_si256(reach, _mm256_loadu_si256(&bitRows[rowNext])));
+            if (clip) newBits = _mm256_and_si256(newBits, _mm256_loadu_si256(&clipRows[rowNext]));
+            if (!_mm256_testz_si256(newBits, newBits))
+            {
+                if (touched) TouchRow(touched, (const uint64*)&fillRows[rowNext], 4, rowNext);
+                _mm256_storeu_si256(&fillRows[rowNext], _mm256_or_si256(oldFill, newBits));
+                if (!(stackedRows[rowNext/64] & (1llu << (rowNext%64))))
+                {
+                    stackedRows[rowNext/64] |= 1llu << (rowNext%64);
+                    stack[stackCount++] = rowNext;
+                }
+                numFilled += CountBits256(newBits);
+            }
+        }
+    }
+    
+    return numFilled;
+}
+
+TARGET_AVX2 static int SimulSpanFill256(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return ClippedSimulSpanFill256(ctx, bitdeck, 0, dim, filled, seedX, seedY, 0);
+}
+
+int Flood_6(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    if (dim != 256 || FloodActiveTier() < FloodTier_AVX2) return Flood_4(ctx, bitdeck, dim, filled, seedX, seedY);
+    
+    return SimulSpanFill256(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+
+// Carry propagation span fill
+//
+// Adding the filled bits of a span to the span itself carries from the lowest filled bit all the way
+// up to the end of the span, flipping every bit it passes. XOR with the span recovers those bits, so one
+// add fills every span in the row toward the high bits however long it is. Carries can't run into the
+// next span because the bit between spans is clear. The low direction is the same trick on the
+// bit-reversed row.
+
+static FORCE_INLINE uint64 CarryFillLeft(uint64 bitRow, uint64 fillRow)
+{
+    uint64 seeds = fillRow & bitRow;
+    return fillRow | (((bitRow + seeds) ^ bitRow) & bitRow);
+}
+
+static FORCE_INLINE uint64 CarryFillRight(uint64 bitRow, uint64 fillRow)
+{
+    return ReverseBits(CarryFillLeft(ReverseBits(bitRow), ReverseBits(fillRow)));
+}
+
+// Runs the row stack of Flood_3 with carry span expansion over up to 64 rows until nothing changes.
+// Rows on the stack must already be marked in stackedRows. 'diagonals' is FloodDiagonals() of the
+// fill. clipRows (may be null) is ANDed into bitRows as each row is loaded. touched (may be null) notes
+// the rows the stack changes. Returns the number of newly filled bits.
+static FORCE_INLINE int CarrySpanFillRows(const uint64* bitRows, const uint64* clipRows, uint64* fillRows, int numRows, int* stack, int stackCount, uint64 stackedRows, uint64 diagonals, FloodTouchedRows* touched)
+{
+    int numFilled = 0;
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows &= ~(1llu << rowIndex);
+        
+        uint64 bitRow = clipRows ? bitRows[rowIndex] & clipRows[rowIndex] : bitRows[rowIndex];
+        uint64 fillRowStart = fillRows[rowIndex];
+        uint64 fillRow = fillRowStart;
+        
+        // Most rows arrive with their spans already complete from the bitfill, so only pay for a
+        // direction when a filled bit has an open, unfilled neighbour that way.
+        if ((fillRow<<1) & bitRow & ~fillRow)
+        {
+            fillRow = CarryFillLeft(bitRow, fillRow);
+        }
+        if ((fillRow>>1) & bitRow & ~fillRow)
+        {
+            fillRow = CarryFillRight(bitRow, fillRow);
+        }
+        
+        fillRows[rowIndex] = fillRow;
+        numFilled += CountBits(fillRow ^ fillRowStart);
+        uint64 reach = ReachRow(fillRow, diagonals);
+        
+        // Bitfill up
+        if (rowIndex > 0)
+        {
+            uint64 oldFill = fillRows[rowIndex-1];
+            uint64 newFill = oldFill | (reach & bitRows[rowIndex-1] & (clipRows ? clipRows[rowIndex-1] : ~0llu));
+            if (oldFill != newFill)
+            {
+                if (touched) TouchRow(touched, &fillRows[rowIndex-1], 1, rowIndex-1);
+                fillRows[rowIndex-1] = newFill;
+                if (!(stackedRows & (1llu << (rowIndex-1))))
+                {
+                    stackedRows |= 1llu << (rowIndex-1);
+                    stack[stackCount++] = rowIndex-1;
+                }
+                numFilled += CountBits(oldFill ^ newFill);
+            }
+        }
+        
+        // Bitfill down
+        if (rowIndex < numRows-1)
+        {
+            uint64 oldFill = fillRows[rowIndex+1];
+            uint64 newFill = oldFill | (reach & bitRows[rowIndex+1] & (clipRows ? clipRows[rowIndex+1] : ~0llu));
+            if (oldFill != newFill)
+            {
+                if (touched) TouchRow(touched, &fillRows[rowIndex+1], 1, rowIndex+1);
+                fillRows[rowIndex+1] = newFill;
+                if (!(stackedRows & (1llu << (rowIndex+1))))
+                {
+                    stackedRows |= 1llu << (rowIndex+1);
+                    stack[stackCount++] = rowIndex+1;
+                }
+                numFilled += CountBits(oldFill ^ newFill);
+            }
+        }
+    }
+    
+    return numFilled;
+}
+
+static FORCE_INLINE int CarrySimulSpanFill64(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    // Flood_3 with the simulscan loops replaced by CarryFillLeft/Right, so each row visit costs the same
+    // however long its spans are.
+    
+    int* stack = FloodContextStack(ctx, dim); 
+    int stackCount = 0;
+    uint64 stackedRows = 0;
+    int numFilled = 0;
+    
+    // Test and add seed cell to stack    
+    int cellIndex = FillCell(bitdeck, dim, filled, seedX, seedY);
+    if (cellIndex >= 0)
+    {
+        // We stack row numbers, not cell numbers
+        stack[stackCount++] = cellIndex/64;
+        stackedRows |= 1llu << (cellIndex/64);
+        ++numFilled;
+    }
+    
+    return numFilled + CarrySpanFillRows((const uint64*)bitdeck, 0, (uint64*)filled, dim, stack, stackCount, stackedRows, FloodDiagonals(ctx), 0);
+}
+
+int Flood_7(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return CarrySimulSpanFill64(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+
+// Register resident deck fill
+//
+// A 64x64 deck is 512 bytes, exactly eight zmm registers of eight rows each. The fill is grown in
+// registers by alternating a horizontal pass and a vertical pass until the vertical pass adds nothing.
+// Both passes fill straight runs of any length at once, so the number of passes only depends on how
+// many times the region turns a corner, not on its size:
+//   - toward high bits with the carry trick from Flood_7, one add per lane
+//   - toward low bits, up and down with Kogge-Stone doubling steps (shifts of 1, 2, 4, .. 32),
+//     where a row shift of 8 or more is just a register renaming.
+// The horizontal pass always saturates, so a vertical pass that adds nothing means we're done. With
+// 8-connectivity a single diagonal step runs between the two passes, bitfilling each row from its
+// neighbours widened by one cell either side.
+
+// Row r of the result is row r-s of the deck (bits flow down the deck). Iterate k downward when
+// updating in place so register k-1 still holds its old value.
+#define DECK_FROM_ABOVE(regs, k, s) \
+    ((s) < 8 ? _mm512_alignr_epi64((regs)[k], (k) > 0 ? (regs)[(k)-1] : zero, (8-(s))&7) \
+             : ((k) >= (s)/8 ? (regs)[(k)-(s)/8] : zero))
+
+// Row r of the result is row r+s of the deck (bits flow up the deck). Iterate k upward.
+#define DECK_FROM_BELOW(regs, k, s) \
+    ((s) < 8 ? _mm512_alignr_epi64((k) < 7 ? (regs)[(k)+1] : zero, (regs)[k], (s)&7) \
+             : ((k) + (s)/8 < 8 ? (regs)[(k)+(s)/8] : zero))
+
+// Ternary logic immediates, A B C being the three operands in order
+#define TERN_A_OR_B_AND_C       0xf8
+#define TERN_NOT_A_AND_B_OR_C   0xae
+#define TERN_A_AND_B_AND_NOT_C  0x40
+#define TERN_A_OR_B_OR_C        0xfe
+
+// One Kogge-Stone step: gen |= pro & (gen >> s); pro &= pro >> s
+#define DECK_FILL_RIGHT_STEP(g, p, s) \
+    g = _mm512_ternarylogic_epi64(g, p, _mm512_srli_epi64(g, s), TERN_A_OR_B_AND_C); \
+    p = _mm512_and_si512(p, _mm512_srli_epi64(p, s));
+
+#define DECK_FILL_DOWN_STEP(s) \
+    for (int k = 7; k >= 0; --k) \
+    { \
+        __m512i newBits = _mm512_ternarylogic_epi64(pro[k], DECK_FROM_ABOVE(fill, k, s), fill[k], TERN_A_AND_B_AND_NOT_C); \
+        fill[k] = _mm512_or_si512(fill[k], newBits); \
+        changed = _mm512_or_si512(changed, newBits); \
+        pro[k] = _mm512_and_si512(pro[k], DECK_FROM_ABOVE(pro, k, s)); \
+    }
+
+#define DECK_FILL_UP_STEP(s) \
+    for (int k = 0; k < 8; ++k) \
+    { \
+        __m512i newBits = _mm512_ternarylogic_epi64(pro[k], DECK_FROM_BELOW(fill, k, s), fill[k], TERN_A_AND_B_AND_NOT_C); \
+        fill[k] = _mm512_or_si512(fill[k], newBits); \
+        changed = _mm512_or_si512(changed, newBits); \
+        pro[k] = _mm512_and_si512(pro[k], DECK_FROM_BELOW(pro, k, s)); \
+    }
+
+TARGET_AVX512 static int RegisterDeckFill64(const uint8* bitdeck, uint8* filled, int seedX, int seedY, bool eightWay)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i bits[8];
+    __m512i fill[8];
+    __m512i pro[8];
+    __m512i reach[8];
+    
+    for (int k = 0; k < 8; ++k)
+    {
+        bits[k] = _mm512_loadu_si512(bitdeck + 64*k);
+        fill[k] = zero;
+    }
+    fill[seedY/8] = _mm512_mask_set1_epi64(zero, (__mmask8)(1 << (seedY%8)), (long long)(1llu << seedX));
+    
+    for (;;)
+    {
+        // Horizontal pass
+        for (int k = 0; k < 8; ++k)
+        {
+            // Carry fill toward high bits: fill | (bits & ~(bits + fill))
+            __m512i g = _mm512_ternarylogic_epi64(_mm512_add_epi64(bits[k], fill[k]), bits[k], fill[k], TERN_NOT_A_AND_B_OR_C);
+            __m512i p = bits[k];
+            DECK_FILL_RIGHT_STEP(g, p, 1)
+            DECK_FILL_RIGHT_STEP(g, p, 2)
+            DECK_FILL_RIGHT_STEP(g, p, 4)
+            DECK_FILL_RIGHT_STEP(g, p, 8)
+            DECK_FILL_RIGHT_STEP(g, p, 16)
+            fill[k] = _mm512_ternarylogic_epi64(g, p, _mm512_srli_epi64(g, 32), TERN_A_OR_B_AND_C);
+        }
+        
+        // Vertical pass
+        __m512i changed = zero;
+        
+        if (eightWay)
+        {
+            for (int k = 0; k < 8; ++k)
+            {
+                reach[k] = _mm512_ternarylogic_epi64(fill[k], _mm512_slli_epi64(fill[k], 1), _mm512_srli_epi64(fill[k], 1), TERN_A_OR_B_OR_C);
+            }
+            for (int k = 0; k < 8; ++k)
+            {
+                __m512i neighbours = _mm512_or_si512(DECK_FROM_ABOVE(reach, k, 1), DECK_FROM_BELOW(reach, k, 1));
+                __m512i newBits = _mm512_ternarylogic_epi64(bits[k], neighbours, fill[k], TERN_A_AND_B_AND_NOT_C);
+                fill[k] = _mm512_or_si512(fill[k], newBits);
+                changed = _mm512_or_si512(changed, newBits);
+            }
+        }
+        
+        for (int k = 0; k < 8; ++k) pro[k] = bits[k];
+        DECK_FILL_DOWN_STEP(1)
+        DECK_FILL_DOWN_STEP(2)
+        DECK_FILL_DOWN_STEP(4)
+        DECK_FILL_DOWN_STEP(8)
+        DECK_FILL_DOWN_STEP(16)
+        DECK_FILL_DOWN_STEP(32)
+        
+        for (int k = 0; k < 8; ++k) pro[k] = bits[k];
+        DECK_FILL_UP_STEP(1)
+        DECK_FILL_UP_STEP(2)
+        DECK_FILL_UP_STEP(4)
+        DECK_FILL_UP_STEP(8)
+        DECK_FILL_UP_STEP(16)
+        DECK_FILL_UP_STEP(32)
+        
+        if (!_mm512_test_epi64_mask(changed, changed)) break;
+    }
+    
+    // Merge into the caller's fill and count what was new
+    int numFilled = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+        __m512i oldFill = _mm512_loadu_si512(filled + 64*k);
+        uint64 newBits[8];
+        _mm512_storeu_si512(newBits, _mm512_andnot_si512(oldFill, fill[k]));
+        _mm512_storeu_si512(filled + 64*k, _mm512_or_si512(oldFill, fill[k]));
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            numFilled += CountBits(newBits[lane]);
+        }
+    }
+    
+    return numFilled;
+}
+
+int Flood_8(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    if (dim != 64) return Flood_4(ctx, bitdeck, dim, filled, seedX, seedY);
+    if (FloodActiveTier() < FloodTier_AVX512) return Flood_7(ctx, bitdeck, dim, filled, seedX, seedY);
+    
+    // Same seed test as the other algorithms, an unfillable or already filled seed fills nothing
+    if (TestCell(bitdeck, dim, filled, seedX, seedY) < 0) return 0;
+    
+    return RegisterDeckFill64(bitdeck, filled, seedX, seedY, ctx->Connectivity == 8);
+}
+
+
+// Word span fill
+//
+// Flood_2 with the per-cell work taken out. The open cells of a row are bitdeck & ~filled, so the span
+// around a seed ends at the first clear bit of that on either side, found with one tzcnt/lzcnt per word
+// the span touches. The span is filled with one mask per word, and the rows above and below are scanned
+// for runs with x & ~(x<<1), pushing one seed per run start just like Flood_2 does. Rows are whole words
+// (padded for unaligned dims like Flood_4), so this works at any width up to 32768.
+
+// Bits lo..hi of a row that land in word w, lo <= hi.
+static FORCE_INLINE uint64 SpanWordMask(int w, int lo, int hi)
+{
+    int first = lo - w*64;
+    int last = hi - w*64;
+    uint64 mask = ~0llu;
+    if (first > 0) mask &= ~0llu << first;
+    if (last < 63) mask &= ~0llu >> (63 - last);
+    return mask;
+}
+
+// Stack entries are row << 16 | x, which keeps a divide out of every pop.
+static FORCE_INLINE int PushRunStarts(uint64 starts, int rowIndex, int wordX, int* stack, int stackCount)
+{
+    while (starts)
+    {
+        stack[stackCount++] = (rowIndex << 16) | (wordX + LowestBit(starts));
+        starts &= starts - 1;
+    }
+    return stackCount;
+}
+
+// Pushes one seed per run of open cells in bits lo..hi of a row, carrying runs across words.
+static FORCE_INLINE int PushSeedRuns(const uint64* bitRow, const uint64* fillRow, int rowIndex, int lo, int hi, int* stack, int stackCount)
+{
+    uint64 carry = 0;
+    for (int w = lo/64; w <= hi/64; ++w)
+    {
+        uint64 open = bitRow[w] & ~fillRow[w] & SpanWordMask(w, lo, hi);
+        stackCount = PushRunStarts(open & ~((open << 1) | carry), rowIndex, w*64, stack, stackCount);
+        carry = open >> 63;
+    }
+    return stackCount;
+}
+
+static FORCE_INLINE int WordSpanFillRows(FloodContext* ctx, const uint64* bitRows, uint64* fillRows, int dim, int seedX, int seedY)
+{
+    if ((seedX < 0) | (seedX >= dim) | (seedY < 0) | (seedY >= dim)) return 0;
+    
+    // Same bound as Flood_2. One span pushes at most one seed per two cells above and below it, and the
+    // stack is grown before a span could overrun it, so no deck can break it.
+    int rowWords = RowWords(dim);
+    int reachX = ctx->Connectivity == 8 ? 1 : 0;
+    int* stack = FloodContextStack(ctx, (size_t)dim*dim);
+    int stackCount = 0;
+    int numFilled = 0;
+    
+    stack[stackCount++] = (seedY << 16) | seedX;
+    
+    while (stackCount)
+    {
+        int entry = stack[--stackCount];
+        int y = entry >> 16;
+        int x = entry & 0xffff;
+        const uint64* bitRow = bitRows + (size_t)y*rowWords;
+        uint64* fillRow = fillRows + (size_t)y*rowWords;
+        
+        // Seeds can be filled by another span after they were pushed
+        int seedWord = x/64;
+        uint64 seedBit = 1llu << (x%64);
+        if (!(bitRow[seedWord] & ~fillRow[seedWord] & seedBit)) continue;
+        
+        // Span end to the right, the first blocked bit at or above the seed. Padding bits are never
+        // open, so only a row of whole words can run off the end.
+        int w = seedWord;
+        uint64 blocked = ~(bitRow[w] & ~fillRow[w]) & ~(seedBit - 1);
+        while (!blocked && ++w < rowWords) blocked = ~(bitRow[w] & ~fillRow[w]);
+        int xRight = blocked ? w*64 + LowestBit(blocked) - 1 : dim - 1;
+        
+        // Span end to the left, the first blocked bit at or below the seed
+        w = seedWord;
+        blocked = ~(bitRow[w] & ~fillRow[w]) & (seedBit - 1);
+        while (!blocked && --w >= 0) blocked = ~(bitRow[w] & ~fillRow[w]);
+        int xLeft = blocked ? w*64 + HighestBit(blocked) + 1 : 0;
+        
+        numFilled += xRight - xLeft + 1;
+        
+        // The rows above and below are scanned one cell past the span with 8-connectivity
+        int scanLeft = xLeft > 0 ? xLeft - reachX : 0;
+        int scanRight = xRight < dim-1 ? xRight + reachX : dim - 1;
+        
+        if ((size_t)stackCount + (scanRight - scanLeft + 2) > ctx->StackCapacity)
+        {
+            stack = FloodContextStack(ctx, 2*ctx->StackCapacity);
+        }
+        
+        if (scanLeft/64 == scanRight/64)
+        {
+            // Most spans sit inside one word, fill and scan above and below with one mask
+            w = seedWord;
+            fillRow[w] |= SpanWordMask(w, xLeft, xRight);
+            uint64 scan = SpanWordMask(w, scanLeft, scanRight);
+            if (y > 0)
+            {
+                uint64 open = bitRow[w - rowWords] & ~fillRow[w - rowWords] & scan;
+                stackCount = PushRunStarts(open & ~(open << 1), y-1, w*64, stack, stackCount);
+            }
+            if (y < dim-1)
+            {
+                uint64 open = bitRow[w + rowWords] & ~fillRow[w + rowWords] & scan;
+                stackCount = PushRunStarts(open & ~(open << 1), y+1, w*64, stack, stackCount);
+            }
+            continue;
+        }
+        
+        for (w = xLeft/64; w <= xRight/64; ++w)
+        {
+            fillRow[w] |= SpanWordMask(w, xLeft, xRight);
+        }
+        
+        // Scan above and below for seed runs, push
+        if (y > 0)
+        {
+            stackCount = PushSeedRuns(bitRow - rowWords, fillRow - rowWords, y-1, scanLeft, scanRight, stack, stackCount);
+        }
+        if (y < dim-1)
+        {
+            stackCount = PushSeedRuns(bitRow + rowWords, fillRow + rowWords, y+1, scanLeft, scanRight, stack, stackCount);
+        }
+    }
+    
+    return numFilled;
+}
+
+static FORCE_INLINE int WordSpanFill(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    if (dim % 64 == 0)
+    {
+        return WordSpanFillRows(ctx, (const uint64*)bitdeck, (uint64*)filled, dim, seedX, seedY);
+    }
+    
+    size_t rowsWords = (size_t)RowWords(dim)*dim;
+    uint64* bitRows = FloodContextRows(ctx, 2*rowsWords);
+    uint64* fillRows = bitRows + rowsWords;
+    PadRows(bitdeck, dim, bitRows);
+    PadRows(filled, dim, fillRows);
+    
+    int numFilled = WordSpanFillRows(ctx, bitRows, fillRows, dim, seedX, seedY);
+    
+    UnpadRows(fillRows, dim, filled);
+    
+    return numFilled;
+}
+
+int Flood_9(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return WordSpanFill(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+
+// Region labelling
+//
+// Every row is cut into runs of set bits, a word at a time: run starts are bits & ~(bits<<1) and run
+// ends bits & ~(bits>>1), each with the neighbouring word's edge bit carried in. A row has at most
+// dim/2 runs, so the whole deck is far fewer runs than cells. Runs of neighbouring rows that overlap
+// are 4-connected, and one merge-like walk over the two rows finds every overlap. They're joined in a
+// union-find where the root is always the lowest run index, so the root of each region is its first
+// run in raster order, and the labels come out in the same order repeated fills from the first
+// unfilled cell would give.
+
+typedef struct RowRun
+{
+    int Y;
+    int X0;
+    int X1;
+    int Parent;
+    int Label;
+} RowRun;
+
+static RowRun* FloodContextRuns(FloodContext* ctx, size_t count)
+{
+    return FloodContextReserve((void**)&ctx->Runs, &ctx->RunsCapacity, count, sizeof(RowRun));
+}
+
+static FORCE_INLINE int FindRun(RowRun* runs, int run)
+{
+    while (runs[run].Parent != run)
+    {
+        // Path halving
+        runs[run].Parent = runs[runs[run].Parent].Parent;
+        run = runs[run].Parent;
+    }
+    return run;
+}
+
+static FORCE_INLINE void JoinRuns(RowRun* runs, int a, int b)
+{
+    a = FindRun(runs, a);
+    b = FindRun(runs, b);
+    if (a < b) runs[b].Parent = a;
+    else if (b < a) runs[a].Parent = b;
+}
+
+// Appends the runs of one row of whole words. Returns the new run count.
+static int CollectRowRuns(const uint64* bitRow, int rowWords, int y, RowRun* runs, int numRuns)
+{
+    int endRun = numRuns;
+    uint64 carry = 0;
+    for (int w = 0; w < rowWords; ++w)
+    {
+        uint64 bits = bitRow[w];
+        uint64 next = (w + 1 < rowWords) ? bitRow[w + 1] << 63 : 0;
+        uint64 starts = bits & ~((bits << 1) | carry);
+        uint64 ends = bits & ~((bits >> 1) | next);
+        carry = bits >> 63;
+        
+        // Starts and ends alternate along the row, so the k-th end closes the k-th run
+        while (starts)
+        {
+            RowRun* run = &runs[numRuns];
+            run->Y = y;
+            run->X0 = w*64 + LowestBit(starts);
+            run->Parent = numRuns++;
+            starts &= starts - 1;
+        }
+        while (ends)
+        {
+            runs[endRun++].X1 = w*64 + LowestBit(ends);
+            ends &= ends - 1;
+        }
+    }
+    return numRuns;
+}
+
+int Flood_Label(FloodContext* ctx, const uint8* bitdeck, int dim, int* labels, int* areas)
+{
+    int rowWords = RowWords(dim);
+    const uint64* bitRows = (const uint64*)bitdeck;
+    if (dim % 64 != 0)
+    {
+        uint64* paddedRows = FloodContextRows(ctx, (size_t)rowWords*dim);
+        PadRows(bitdeck, dim, paddedRows);
+        bitRows = paddedRows;
+    }
+    
+    RowRun* runs = FloodContextRuns(ctx, (size_t)dim*((dim + 1)/2));
+    int* rowStart = FloodContextStack(ctx, dim + 1);
+    int numRuns = 0;
+    
+    // With 8-connectivity a run also touches the runs that start or end one cell past it diagonally
+    int reachX = ctx->Connectivity == 8 ? 1 : 0;
+    
+    for (int y = 0; y < dim; ++y)
+    {
+        rowStart[y] = numRuns;
+        numRuns = CollectRowRuns(bitRows + (size_t)y*rowWords, rowWords, y, runs, numRuns);
+        
+        // Join with every touching run of the row above
+        if (y > 0)
+        {
+            int above = rowStart[y-1];
+            int below = rowStart[y];
+            while (above < rowStart[y] && below < numRuns)
+            {
+                if (runs[above].X0 - reachX <= runs[below].X1 && runs[below].X0 <= runs[above].X1 + reachX)
+                {
+                    // A run with no parent yet just hangs off the root above, which always has a lower index
+                    if (runs[below].Parent == below) runs[below].Parent = FindRun(runs, above);
+                    else JoinRuns(runs, above, below);
+                }
+                if (runs[above].X1 + reachX <= runs[below].X1) ++above;
+                else ++below;
+            }
+        }
+    }
+    rowStart[dim] = numRuns;
+    
+    // A parent always has a lower index than its child, so in run order every parent is labelled before
+    // its children and no find is needed here
+    memset(labels, 0xff, sizeof(int)*dim*dim);
+    int numLabels = 0;
+    for (int r = 0; r < numRuns; ++r)
+    {
+        RowRun* run = &runs[r];
+        if (run->Parent == r)
+        {
+            run->Label = numLabels++;
+            if (areas) areas[run->Label] = 0;
+        }
+        else
+        {
+            run->Label = runs[run->Parent].Label;
+        }
+        
+        if (areas) areas[run->Label] += run->X1 - run->X0 + 1;
+        
+        int* rowLabels = labels + (size_t)run->Y*dim;
+        for (int x = run->X0; x <= run->X1; ++x)
+        {
+            rowLabels[x] = run->Label;
+        }
+    }
+    
+    return numLabels;
+}
+
+
+// Reachability
+//
+// Two Flood_4 style row stack fills, one from each end, taking turns a row at a time. After each row
+// the three rows it touched are checked against the other fill, and any shared bit means the ends are
+// connected. A fill that runs out has found its whole region without meeting the other one. Fill rows
+// are only cleared when a fill first touches them, so a query that meets early doesn't pay for clearing
+// the whole plane.
+
+typedef struct
+{
+    uint64* FillRows;
+    uint64* LiveRows;       // Rows of FillRows written by this query, the rest hold stale bits
+    uint64* StackedRows;
+    int* Stack;
+    int StackCount;
+} ReachFront;
+
+static FORCE_INLINE bool ReachRowLive(const ReachFront* front, int row)
+{
+    return (front->LiveRows[row/64] >> (row%64)) & 1;
+}
+
+static FORCE_INLINE uint64* ReachFrontRow(ReachFront* front, int row, int rowWords)
+{
+    uint64* fillRow = front->FillRows + (size_t)row*rowWords;
+    if (!ReachRowLive(front, row))
+    {
+        front->LiveRows[row/64] |= 1llu << (row%64);
+        memset(fillRow, 0, sizeof(uint64)*rowWords);
+    }
+    return fillRow;
+}
+
+// Pops one row, completes its spans and bitfills the rows above and below. Returns the row.
+static int ReachFrontStep(ReachFront* front, const uint64* bitRows, int dim, int rowWords, uint64 diagonals)
+{
+    int rowIndex = front->Stack[--front->StackCount];
+    front->StackedRows[rowIndex/64] &= ~(1llu << (rowIndex%64));
+    
+    uint64* fillRow = ReachFrontRow(front, rowIndex, rowWords);
+    SimulScanRow(bitRows + (size_t)rowIndex*rowWords, 0, fillRow, rowWords);
+    
+    for (int rowNext = rowIndex-1; rowNext <= rowIndex+1; rowNext += 2)
+    {
+        // Bitfill up, then down
+        if ((rowNext < 0) | (rowNext >= dim)) continue;
+        
+        uint64* fillRowNext = ReachFrontRow(front, rowNext, rowWords);
+        if (SimulFillRow(fillRow, bitRows + (size_t)rowNext*rowWords, 0, fillRowNext, rowWords, diagonals, 0, rowNext) &&
+            !(front->StackedRows[rowNext/64] & (1llu << (rowNext%64))))
+        {
+            front->StackedRows[rowNext/64] |= 1llu << (rowNext%64);
+            front->Stack[front->StackCount++] = rowNext;
+        }
+    }
+    
+    return rowIndex;
+}
+
+// True when the fills share a bit on any of the rows around rowIndex
+static bool ReachFrontsMeet(const ReachFront* front, const ReachFront* other, int rowIndex, int dim, int rowWords)
+{
+    int first = rowIndex > 0 ? rowIndex-1 : 0;
+    int last = rowIndex < dim-1 ? rowIndex+1 : dim-1;
+    for (int row = first; row <= last; ++row)
+    {
+        if (!ReachRowLive(front, row) || !ReachRowLive(other, row)) continue;
+        
+        const uint64* a = front->FillRows + (size_t)row*rowWords;
+        const uint64* b = other->FillRows + (size_t)row*rowWords;
+        for (int w = 0; w < rowWords; ++w)
+        {
+            if (a[w] & b[w]) return true;
+        }
+    }
+    return false;
+}
+
+// Grows fills from two distinct open cells in turn. Returns -1 when they meet, otherwise the index of the
+// fill that ran out, which is left in fronts[] holding that whole region.
+static int GrowReachFronts(FloodContext* ctx, const uint8* bitdeck, int dim, int ax, int ay, int bx, int by, ReachFront* fronts)
+{
+    int rowWords = RowWords(dim);
+    int flagWords = (dim + 63)/64;
+    size_t rowsWords = (size_t)rowWords*dim;
+    uint64 diagonals = FloodDiagonals(ctx);
+    
+    uint64* rows = FloodContextRows(ctx, 3*rowsWords);
+    const uint64* bitRows = (const uint64*)bitdeck;
+    if (dim % 64 != 0)
+    {
+        PadRows(bitdeck, dim, rows + 2*rowsWords);
+        bitRows = rows + 2*rowsWords;
+    }
+    
+    uint64* flags = FloodContextRowFlags(ctx, 4*flagWords);
+    memset(flags, 0, sizeof(uint64)*4*flagWords);
+    int* stack = FloodContextStack(ctx, 2*dim);
+    
+    const int seedX[2] = { ax, bx };
+    const int seedY[2] = { ay, by };
+    for (int f = 0; f < 2; ++f)
+    {
+        ReachFront* front = &fronts[f];
+        front->FillRows = rows + f*rowsWords;
+        front->LiveRows = flags + (2*f)*flagWords;
+        front->StackedRows = flags + (2*f + 1)*flagWords;
+        front->Stack = stack + f*dim;
+        front->StackCount = 0;
+        
+        ReachFrontRow(front, seedY[f], rowWords)[seedX[f]/64] |= 1llu << (seedX[f]%64);
+        front->StackedRows[seedY[f]/64] |= 1llu << (seedY[f]%64);
+        front->Stack[front->StackCount++] = seedY[f];
+    }
+    
+    for (int f = 0; ; f ^= 1)
+    {
+        ReachFront* front = &fronts[f];
+        if (!front->StackCount) return f;
+        
+        int rowIndex = ReachFrontStep(front, bitRows, dim, rowWords, diagonals);
+        if (ReachFrontsMeet(front, &fronts[f^1], rowIndex, dim, rowWords)) return -1;
+    }
+}
+
+bool Flood_Reachable(FloodContext* ctx, const uint8* bitdeck, int dim, int ax, int ay, int bx, int by)
+{
+    if ((ax < 0) | (ax >= dim) | (ay < 0) | (ay >= dim)) return false;
+    if ((bx < 0) | (bx >= dim) | (by < 0) | (by >= dim)) return false;
+    if (!(bitdeck[(ay*dim + ax) >> 3] & (1 << ((ay*dim + ax)&7)))) return false;
+    if (!(bitdeck[(by*dim + bx) >> 3] & (1 << ((by*dim + bx)&7)))) return false;
+    if ((ax == bx) & (ay == by)) return true;
+    
+    ReachFront fronts[2];
+    return GrowReachFronts(ctx, bitdeck, dim, ax, ay, bx, by, fronts) < 0;
+}
+
+
+// Bounded fill and region stats
+//
+// The Flood_4 row loop with the limits checked once per popped row, against the running count and the
+// row just completed. Every row that gains cells is popped and completed before the fill ends, so a
+// fill that isn't truncated is the whole region, and a truncated one has seen a cell past the limit.
+//
+// Region stats run the same kernel Flood_Dispatch would, the multi-word row stack of Flood_4 for sizes
+// without one of their own. The kernel notes each row before it first changes, and once the
+// fill is done the stats are taken from the newly filled bits of those rows alone. That's one
+// AddWordStats per changed word, where counting the bits as the rows gain them paid again every time a
+// maze row was revisited, and rows the fill never reached are never read.
+
+// True when a completed row holds a cell outside the box columns
+static bool RowLeavesBox(const uint64* fillRow, int rowWords, const FloodLimits* limits)
+{
+    for (int w = 0; w < rowWords; ++w)
+    {
+        uint64 inside = (w*64 + 63 < limits->MinX || w*64 > limits->MaxX) ? 0 : SpanWordMask(w, limits->MinX, limits->MaxX);
+        if (fillRow[w] & ~inside) return true;
+    }
+    return false;
+}
+
+static FORCE_INLINE int BoundedFillRows(FloodContext* ctx, const uint64* bitRows, uint64* fillRows, int dim, int seedX, int seedY, const FloodLimits* limits, bool* truncated)
+{
+    int rowWords = RowWords(dim);
+    uint64 diagonals = FloodDiagonals(ctx);
+    int* stack = FloodContextStack(ctx, dim);
+    int stackCount = 0;
+    uint64* stackedRows = FloodContextRowFlags(ctx, rowWords);
+    memset(stackedRows, 0, sizeof(uint64)*rowWords);
+    int maxCells = limits->MaxCells > 0 ? limits->MaxCells : INT_MAX;
+    int numFilled = 0;
+    
+    int seedWord = seedY*rowWords + seedX/64;
+    uint64 seedBit = 1llu << (seedX%64);
+    if ((bitRows[seedWord] & seedBit) && !(fillRows[seedWord] & seedBit))
+    {
+        fillRows[seedWord] |= seedBit;
+        stack[stackCount++] = seedY;
+        stackedRows[seedY/64] |= 1llu << (seedY%64);
+        ++numFilled;
+    }
+    
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows[rowIndex/64] &= ~(1llu << (rowIndex%64));
+        
+        uint64* fillRow = fillRows + (size_t)rowIndex*rowWords;
+        numFilled += SimulScanRow(bitRows + (size_t)rowIndex*rowWords, 0, fillRow, rowWords);
+        
+        if (numFilled > maxCells ||
+            (limits->UseBox && (rowIndex < limits->MinY || rowIndex > limits->MaxY || RowLeavesBox(fillRow, rowWords, limits))))
+        {
+            *truncated = true;
+            break;
+        }
+        
+        for (int rowNext = rowIndex-1; rowNext <= rowIndex+1; rowNext += 2)
+        {
+            // Bitfill up, then down
+            if ((rowNext < 0) | (rowNext >= dim)) continue;
+            
+            int rowFilled = SimulFillRow(fillRow, bitRows + (size_t)rowNext*rowWords, 0, fillRows + (size_t)rowNext*rowWords, rowWords, diagonals, 0, rowNext);
+            if (rowFilled && !(stackedRows[rowNext/64] & (1llu << (rowNext%64))))
+            {
+                stackedRows[rowNext/64] |= 1llu << (rowNext%64);
+                stack[stackCount++] = rowNext;
+            }
+            numFilled += rowFilled;
+        }
+    }
+    
+    return numFilled;
+}
+
+static int BoundedFillRowsBaseline(FloodContext* ctx, const uint64* bitRows, uint64* fillRows, int dim, int seedX, int seedY, const FloodLimits* limits, bool* truncated)
+{
+    return BoundedFillRows(ctx, bitRows, fillRows, dim, seedX, seedY, limits, truncated);
+}
+
+// The popcounts and bit scans are library calls in baseline code, so take the BMI2 build when we can
+TARGET_BMI2 static int BoundedFillRows_BMI2(FloodContext* ctx, const uint64* bitRows, uint64* fillRows, int dim, int seedX, int seedY, const FloodLimits* limits, bool* truncated)
+{
+    return BoundedFillRows(ctx, bitRows, fillRows, dim, seedX, seedY, limits, truncated);
+}
+
+static int BoundedFill(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, const FloodLimits* limits, bool* truncated)
+{
+    bool wasTruncated = false;
+    int numFilled = 0;
+    int (*fillRowsFn)(FloodContext*, const uint64*, uint64*, int, int, int, const FloodLimits*, bool*) =
+        FloodActiveTier() >= FloodTier_BMI2 ? BoundedFillRows_BMI2 : BoundedFillRowsBaseline;
+    
+    if ((seedX >= 0) & (seedX < dim) & (seedY >= 0) & (seedY < dim))
+    {
+        if (dim % 64 == 0)
+        {
+            numFilled = fillRowsFn(ctx, (const uint64*)bitdeck, (uint64*)filled, dim, seedX, seedY, limits, &wasTruncated);
+        }
+        else
+        {
+            size_t rowsWords = (size_t)RowWords(dim)*dim;
+            uint64* bitRows = FloodContextRows(ctx, 2*rowsWords);
+            uint64* fillRows = bitRows + rowsWords;
+            PadRows(bitdeck, dim, bitRows);
+            PadRows(filled, dim, fillRows);
+            
+            numFilled = fillRowsFn(ctx, bitRows, fillRows, dim, seedX, seedY, limits, &wasTruncated);
+            
+            UnpadRows(fillRows, dim, filled);
+        }
+    }
+    
+    if (truncated) *truncated = wasTruncated;
+    return numFilled;
+}
+
+int Flood_Bounded(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, const FloodLimits* limits, bool* truncated)
+{
+    return BoundedFill(ctx, bitdeck, dim, filled, seedX, seedY, limits, truncated);
+}
+
+static void ResetStats(FloodStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->MinX = stats->MinY = INT_MAX;
+    stats->MaxX = stats->MaxY = -1;
+}
+
+// Touched rows in the context's rows scratch, after 'skipWords' words of it
+static FloodTouchedRows ReserveTouchedRows(FloodContext* ctx, int dim, size_t skipWords)
+{
+    int rowWords = RowWords(dim);
+    size_t rowsWords = (size_t)rowWords*dim;
+    uint64* rows = FloodContextRows(ctx, skipWords + rowsWords + rowWords) + skipWords;
+    
+    FloodTouchedRows touched;
+    touched.StartRows = rows;
+    touched.Rows = rows + rowsWords;
+    memset(touched.Rows, 0, sizeof(uint64)*rowWords);
+    return touched;
+}
+
+// The kernels of Flood_Dispatch for 64 and 128, and the multi-word row stack for the rest, each noting
+// the rows it changes. The seed must be on the plane.
+static FORCE_INLINE int StatsFill(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, FloodStats* stats)
+{
+    int rowWords = RowWords(dim);
+    size_t rowsWords = (size_t)rowWords*dim;
+    const uint64* bitRows = (const uint64*)bitdeck;
+    uint64* fillRows = (uint64*)filled;
+    FloodTouchedRows touched;
+    if (dim % 64)
+    {
+        touched = ReserveTouchedRows(ctx, dim, 2*rowsWords);
+        uint64* paddedRows = ctx->Rows;
+        bitRows = paddedRows;
+        fillRows = paddedRows + rowsWords;
+        PadRows(bitdeck, dim, paddedRows);
+        PadRows(filled, dim, fillRows);
+    }
+    else
+    {
+        touched = ReserveTouchedRows(ctx, dim, 0);
+    }
+    
+    int numFilled = 0;
+    if (dim == 128)
+    {
+        numFilled = ClippedSimulSpanFill128(ctx, bitdeck, 0, dim, filled, seedX, seedY, &touched);
+    }
+    else
+    {
+        int seedWord = seedY*rowWords + seedX/64;
+        uint64 seedBit = 1llu << (seedX%64);
+        if ((bitRows[seedWord] & seedBit) && !(fillRows[seedWord] & seedBit))
+        {
+            TouchRow(&touched, fillRows + (size_t)seedY*rowWords, rowWords, seedY);
+            fillRows[seedWord] |= seedBit;
+            ++numFilled;
+            
+            int* stack = FloodContextStack(ctx, dim);
+            stack[0] = seedY;
+            if (dim == 64)
+            {
+                numFilled += CarrySpanFillRows(bitRows, 0, fillRows, dim, stack, 1, 1llu << seedY, FloodDiagonals(ctx), &touched);
+            }
+            else
+            {
+                uint64* stackedRows = FloodContextRowFlags(ctx, rowWords);
+                memset(stackedRows, 0, sizeof(uint64)*rowWords);
+                stackedRows[seedY/64] |= 1llu << (seedY%64);
+                numFilled += SimulSpanFillStack(bitRows, 0, fillRows, dim, stack, 1, stackedRows, FloodDiagonals(ctx), &touched);
+            }
+        }
+    }
+    
+    AddTouchedRowStats(stats, &touched, fillRows, dim);
+    if (dim % 64) UnpadRows(fillRows, dim, filled);
+    
+    return numFilled;
+}
+
+static int StatsFillBaseline(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, FloodStats* stats)
+{
+    return StatsFill(ctx, bitdeck, dim, filled, seedX, seedY, stats);
+}
+
+TARGET_BMI2 static int StatsFill_BMI2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, FloodStats* stats)
+{
+    return StatsFill(ctx, bitdeck, dim, filled, seedX, seedY, stats);
+}
+
+TARGET_AVX2 static int StatsFill256_AVX2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, FloodStats* stats)
+{
+    FloodTouchedRows touched = ReserveTouchedRows(ctx, dim, 0);
+    int numFilled = ClippedSimulSpanFill256(ctx, bitdeck, 0, dim, filled, seedX, seedY, &touched);
+    AddTouchedRowStats(stats, &touched, (const uint64*)filled, dim);
+    return numFilled;
+}
+
+int Flood_Stats(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, FloodStats* stats)
+{
+    ResetStats(stats);
+    if ((seedX < 0) | (seedX >= dim) | (seedY < 0) | (seedY >= dim)) return 0;
+    
+    if (dim == 256 && FloodActiveTier() >= FloodTier_AVX2) return StatsFill256_AVX2(ctx, bitdeck, dim, filled, seedX, seedY, stats);
+    if (FloodActiveTier() >= FloodTier_BMI2) return StatsFill_BMI2(ctx, bitdeck, dim, filled, seedX, seedY, stats);
+    return StatsFillBaseline(ctx, bitdeck, dim, filled, seedX, seedY, stats);
+}
+
+void FloodStatsOfDeck(const uint8* deck, int dim, FloodStats* stats)
+{
+    ResetStats(stats);
+    if (dim % 64 == 0)
+    {
+        const uint64* rows = (const uint64*)deck;
+        for (int y = 0; y < dim; ++y)
+        {
+            for (int w = 0; w < dim/64; ++w)
+            {
+                AddWordStats(stats, rows[(size_t)y*(dim/64) + w], w*64, y);
+            }
+        }
+        return;
+    }
+    
+    for (int y = 0; y < dim; ++y)
+    {
+        for (int x = 0; x < dim; x += 64)
+        {
+            int numBits = (dim - x) < 64 ? (dim - x) : 64;
+            AddWordStats(stats, LoadBits(deck, (size_t)y*dim + x, numBits), x, y);
+        }
+    }
+}
+
+
+// Fill maintenance
+//
+// Setting a cell can only grow the fill, and only when the cell touches it, so that's one ordinary fill
+// from the cell, which stops wherever it runs into cells already filled. Clearing a filled cell can only
+// shrink the fill, by cutting the region into pieces that each hold some of the cell's filled neighbours.
+// Neighbours still joined around the cell's own ring of eight are grouped first, which settles most
+// edits in open ground without any fill. Groups left over are told apart with the two ended fills of
+// Flood_Reachable run over 'filled' itself: fronts that meet join two groups, and a front that runs out
+// has found a whole piece, which is kept if it holds the seed and cut out otherwise. Either way the
+// work scales with the smaller piece rather than the region.
+
+// The ring of cells around a cell, clockwise from the top left. Odd entries are the 4-way neighbours.
+static const int RingX[8] = { -1, 0, 1, 1, 1, 0, -1, -1 };
+static const int RingY[8] = { -1, -1, -1, 0, 1, 1, 1, 0 };
+
+static FORCE_INLINE bool DeckCell(const uint8* deck, int dim, int x, int y)
+{
+    if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) return false;
+    size_t index = (size_t)y*dim + x;
+    return (deck[index >> 3] >> (index & 7)) & 1;
+}
+
+static FORCE_INLINE void WriteDeckCell(uint8* deck, int dim, int x, int y, bool set)
+{
+    size_t index = (size_t)y*dim + x;
+    if (set) deck[index >> 3] |= 1 << (index & 7);
+    else deck[index >> 3] &= ~(1 << (index & 7));
+}
+
+static int FindRingGroup(const int* groups, int k)
+{
+    while (groups[k] != k) k = groups[k];
+    return k;
+}
+
+// Groups the set cells of a ring that still touch without the middle cell, and writes one neighbour of
+// the middle cell per group to reps. Each corner touches the cells either side of it, and with
+// 8-connectivity the side cells touch each other across a corner as well. Groups of corners alone
+// don't touch the middle cell and are left out. Returns the number of groups written.
+static int RingGroups(const bool* ringSet, bool eightWay, int* reps)
+{
+    int groups[8];
+    for (int k = 0; k < 8; ++k) groups[k] = k;
+    for (int k = 0; k < 8; ++k)
+    {
+        int next = (k + 1) % 8;
+        int across = (k + 2) % 8;
+        if (ringSet[k] & ringSet[next]) groups[FindRingGroup(groups, next)] = FindRingGroup(groups, k);
+        if (eightWay & (k & 1) & ringSet[k] & ringSet[across]) groups[FindRingGroup(groups, across)] = FindRingGroup(groups, k);
+    }
+    
+    int numReps = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+        if (!ringSet[k] || !(eightWay || (k & 1))) continue;
+        
+        bool seen = false;
+        for (int r = 0; r < numReps; ++r) seen |= FindRingGroup(groups, reps[r]) == FindRingGroup(groups, k);
+        if (!seen) reps[numReps++] = k;
+    }
+    return numReps;
+}
+
+// Clears the filled cells of a reachability front's piece, or with keepPiece every filled cell outside
+// it. Returns the number of cells cleared.
+static int CutPiece(uint8* filled, int dim, const ReachFront* piece, bool keepPiece)
+{
+    int rowWords = RowWords(dim);
+    int numCleared = 0;
+    for (int y = 0; y < dim; ++y)
+    {
+        bool live = ReachRowLive(piece, y);
+        if (!live && !keepPiece) continue;
+        
+        const uint64* pieceRow = piece->FillRows + (size_t)y*rowWords;
+        for (int w = 0; w < rowWords; ++w)
+        {
+            uint64 pieceBits = live ? pieceRow[w] : 0;
+            uint64 cut = keepPiece ? ~pieceBits : pieceBits;
+            if (dim % 64 == 0)
+            {
+                uint64* word = (uint64*)filled + (size_t)y*rowWords + w;
+                numCleared += (int)CountBits(*word & cut);
+                *word &= ~cut;
+            }
+            else
+            {
+                int numBits = dim - w*64 < 64 ? dim - w*64 : 64;
+                size_t bitIndex = (size_t)y*dim + w*64;
+                uint64 bits = LoadBits(filled, bitIndex, numBits);
+                if (bits & cut)
+                {
+                    numCleared += (int)CountBits(bits & cut);
+                    StoreBits(filled, bitIndex, numBits, bits & ~cut);
+                }
+            }
+        }
+    }
+    return numCleared;
+}
+
+// Takes the cleared cell (x,y) out of the fill along with every piece it cut off from the seed.
+// Returns the number of cells removed besides (x,y) itself.
+static int CutFill(FloodContext* ctx, uint8* filled, int dim, int x, int y, int seedX, int seedY)
+{
+    if ((x == seedX) & (y == seedY))
+    {
+        size_t deckBytes = ((size_t)dim*dim + 7)/8;
+        int numCleared = 0;
+        for (size_t i = 0; i < deckBytes; ++i) numCleared += (int)CountBits(filled[i]);
+        memset(filled, 0, deckBytes);
+        return numCleared;
+    }
+    
+    bool ringFilled[8];
+    for (int k = 0; k < 8; ++k)
+    {
+        ringFilled[k] = DeckCell(filled, dim, x + RingX[k], y + RingY[k]);
+    }
+    
+    int reps[8];
+    int numReps = RingGroups(ringFilled, ctx->Connectivity == 8, reps);
+    
+    int numCleared = 0;
+    while (numReps > 1)
+    {
+        int a = reps[0];
+        int b = reps[numReps-1];
+        ReachFront fronts[2];
+        int exhausted = GrowReachFronts(ctx, filled, dim, x + RingX[a], y + RingY[a], x + RingX[b], y + RingY[b], fronts);
+        if (exhausted < 0)
+        {
+            --numReps;
+            continue;
+        }
+        
+        const ReachFront* piece = &fronts[exhausted];
+        bool holdsSeed = (seedY >= 0) && (seedY < dim) && ReachRowLive(piece, seedY) &&
+            ((piece->FillRows[(size_t)seedY*RowWords(dim) + seedX/64] >> (seedX%64)) & 1);
+        numCleared += CutPiece(filled, dim, piece, holdsSeed);
+        if (holdsSeed) break;
+        
+        if (exhausted == 0) reps[0] = reps[numReps-1];
+        --numReps;
+    }
+    
+    return numCleared;
+}
+
+int Flood_Update(FloodContext* ctx, uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, const FloodEdit* edits, int numEdits)
+{
+    bool eightWay = ctx->Connectivity == 8;
+    int numChanged = 0;
+    
+    for (int e = 0; e < numEdits; ++e)
+    {
+        int x = edits[e].X;
+        int y = edits[e].Y;
+        if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) continue;
+        if (DeckCell(bitdeck, dim, x, y) == edits[e].Set) continue;
+        
+        WriteDeckCell(bitdeck, dim, x, y, edits[e].Set);
+        if (edits[e].Set)
+        {
+            bool touchesFill = (x == seedX) & (y == seedY);
+            for (int k = eightWay ? 0 : 1; k < 8 && !touchesFill; k += eightWay ? 1 : 2)
+            {
+                touchesFill = DeckCell(filled, dim, x + RingX[k], y + RingY[k]);
+            }
+            if (touchesFill) numChanged += Flood_Dispatch(ctx, bitdeck, dim, filled, x, y);
+        }
+        else if (DeckCell(filled, dim, x, y))
+        {
+            WriteDeckCell(filled, dim, x, y, false);
+            numChanged -= 1 + CutFill(ctx, filled, dim, x, y, seedX, seedY);
+        }
+    }
+    
+    return numChanged;
+}
+
+
+// Region index
+//
+// The runs and union-find of Flood_Label, kept around along with a padded copy of the plane, so a cell's
+// region is a binary search of its row's runs and a find. Every root also keeps the band of rows its
+// region may span.
+//
+// Opening a cell only ever joins regions: it extends, bridges or starts a run of its row, which is then
+// joined with the runs the cell touches above and below. Closing a cell trims or splits its run, and
+// only cuts the region when the cell's open neighbours fall into more than one group around its ring.
+// That region alone is then rebuilt: its runs are found by a find over the rows of its band, reset,
+// and joined again with the usual overlap walk. Runs a bridge or a close takes out of a row stay on as
+// inner nodes of the union-find, since other runs may still hang off them, until there are as many of
+// them as live runs and the whole index is rebuilt from the plane.
+
+typedef struct RowBand
+{
+    int Top;
+    int Bottom;
+} RowBand;
+
+void FloodIndexInit(FloodIndex* index)
+{
+    memset(index, 0, sizeof(*index));
+}
+
+void FloodIndexFree(FloodIndex* index)
+{
+    free(index->BitRows);
+    free(index->Runs);
+    free(index->Bands);
+    free(index->RowRuns);
+    free(index->RowRunCounts);
+    free(index->Members);
+    memset(index, 0, sizeof(*index));
+}
+
+// Makes room for count runs, growing by doubling since edits add runs one at a time
+static void IndexReserveRuns(FloodIndex* index, size_t count)
+{
+    if (count <= index->RunsCapacity) return;
+    
+    size_t capacity = Max(count, 2*index->RunsCapacity);
+    FloodContextReserve((void**)&index->Bands, &index->BandsCapacity, capacity, sizeof(RowBand));
+    FloodContextReserve((void**)&index->Runs, &index->RunsCapacity, capacity, sizeof(RowRun));
+}
+
+static int IndexNewRun(FloodIndex* index, int y, int x0, int x1)
+{
+    IndexReserveRuns(index, index->NumRuns + 1);
+    
+    int run = index->NumRuns++;
+    index->Runs[run].Y = y;
+    index->Runs[run].X0 = x0;
+    index->Runs[run].X1 = x1;
+    index->Runs[run].Parent = run;
+    index->Bands[run].Top = index->Bands[run].Bottom = y;
+    return run;
+}
+
+static void IndexJoin(FloodIndex* index, int a, int b)
+{
+    a = FindRun(index->Runs, a);
+    b = FindRun(index->Runs, b);
+    if (a == b) return;
+    
+    int root = a < b ? a : b;
+    int child = a < b ? b : a;
+    index->Runs[child].Parent = root;
+    if (index->Bands[child].Top < index->Bands[root].Top) index->Bands[root].Top = index->Bands[child].Top;
+    if (index->Bands[child].Bottom > index->Bands[root].Bottom) index->Bands[root].Bottom = index->Bands[child].Bottom;
+}
+
+// Joins every run of row y with the runs it touches in the row above
+static void IndexJoinRows(FloodIndex* index, int y)
+{
+    int reachX = index->Connectivity == 8 ? 1 : 0;
+    const int* aboveRuns = index->RowRuns + (size_t)(y-1)*index->MaxRowRuns;
+    const int* belowRuns = index->RowRuns + (size_t)y*index->MaxRowRuns;
+    int numAbove = index->RowRunCounts[y-1];
+    int numBelow = index->RowRunCounts[y];
+    
+    int above = 0;
+    int below = 0;
+    while (above < numAbove && below < numBelow)
+    {
+        const RowRun* a = &index->Runs[aboveRuns[above]];
+        const RowRun* b = &index->Runs[belowRuns[below]];
+        if (a->X0 - reachX <= b->X1 && b->X0 <= a->X1 + reachX) IndexJoin(index, aboveRuns[above], belowRuns[below]);
+        if (a->X1 + reachX <= b->X1) ++above;
+        else ++below;
+    }
+}
+
+static void IndexRebuild(FloodIndex* index)
+{
+    int dim = index->Dim;
+    int rowWords = RowWords(dim);
+    index->NumRuns = 0;
+    index->NumDeadRuns = 0;
+    
+    for (int y = 0; y < dim; ++y)
+    {
+        IndexReserveRuns(index, (size_t)index->NumRuns + index->MaxRowRuns);
+        
+        int firstRun = index->NumRuns;
+        index->NumRuns = CollectRowRuns(index->BitRows + (size_t)y*rowWords, rowWords, y, index->Runs, firstRun);
+        
+        int* rowRuns = index->RowRuns + (size_t)y*index->MaxRowRuns;
+        index->RowRunCounts[y] = index->NumRuns - firstRun;
+        for (int run = firstRun; run < index->NumRuns; ++run)
+        {
+            rowRuns[run - firstRun] = run;
+            index->Bands[run].Top = index->Bands[run].Bottom = y;
+        }
+        
+        if (y > 0) IndexJoinRows(index, y);
+    }
+}
+
+void FloodIndexBuild(FloodIndex* index, const uint8* bitdeck, int dim, int connectivity)
+{
+    index->Dim = dim;
+    index->MaxRowRuns = (dim + 1)/2;
+    FloodContextReserve((void**)&index->BitRows, &index->BitRowsCapacity, (size_t)RowWords(dim)*dim, sizeof(uint64));
+    FloodContextReserve((void**)&index->RowRuns, &index->RowRunsCapacity, (size_t)dim*index->MaxRowRuns, sizeof(int));
+    FloodContextReserve((void**)&index->RowRunCounts, &index->RowRunCountsCapacity, dim, sizeof(int));
+    index->Connectivity = connectivity;
+    
+    if (dim % 64 == 0) memcpy(index->BitRows, bitdeck, (size_t)dim*dim/8);
+    else PadRows(bitdeck, dim, index->BitRows);
+    
+    IndexRebuild(index);
+}
+
+static FORCE_INLINE bool IndexCell(const FloodIndex* index, int x, int y)
+{
+    if ((x < 0) | (x >= index->Dim) | (y < 0) | (y >= index->Dim)) return false;
+    return (index->BitRows[(size_t)y*RowWords(index->Dim) + x/64] >> (x%64)) & 1;
+}
+
+// Position in row y of the last run starting at or before x, -1 if there's none
+static int FindRowRun(const FloodIndex* index, int y, int x)
+{
+    const int* rowRuns = index->RowRuns + (size_t)y*index->MaxRowRuns;
+    int lo = 0;
+    int hi = index->RowRunCounts[y];
+    while (lo < hi)
+    {
+        int mid = (lo + hi)/2;
+        if (index->Runs[rowRuns[mid]].X0 <= x) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo - 1;
+}
+
+static void IndexOpenCell(FloodIndex* index, int x, int y)
+{
+    index->BitRows[(size_t)y*RowWords(index->Dim) + x/64] |= 1llu << (x%64);
+    
+    int* rowRuns = index->RowRuns + (size_t)y*index->MaxRowRuns;
+    int count = index->RowRunCounts[y];
+    int p = FindRowRun(index, y, x) + 1;
+    bool joinsLeft = p > 0 && index->Runs[rowRuns[p-1]].X1 == x - 1;
+    bool joinsRight = p < count && index->Runs[rowRuns[p]].X0 == x + 1;
+    
+    int run;
+    if (joinsLeft && joinsRight)
+    {
+        // The run on the right is taken out of the row but stays in its region's tree
+        run = rowRuns[p-1];
+        index->Runs[run].X1 = index->Runs[rowRuns[p]].X1;
+        IndexJoin(index, run, rowRuns[p]);
+        memmove(rowRuns + p, rowRuns + p + 1, sizeof(int)*(count - p - 1));
+        --index->RowRunCounts[y];
+        ++index->NumDeadRuns;
+    }
+    else if (joinsLeft)
+    {
+        run = rowRuns[p-1];
+        index->Runs[run].X1 = x;
+    }
+    else if (joinsRight)
+    {
+        run = rowRuns[p];
+        index->Runs[run].X0 = x;
+    }
+    else
+    {
+        run = IndexNewRun(index, y, x, x);
+        memmove(rowRuns + p + 1, rowRuns + p, sizeof(int)*(count - p));
+        rowRuns[p] = run;
+        ++index->RowRunCounts[y];
+    }
+    
+    // Join the runs the cell touches above and below
+    int reachX = index->Connectivity == 8 ? 1 : 0;
+    for (int yNext = y-1; yNext <= y+1; yNext += 2)
+    {
+        if ((yNext < 0) | (yNext >= index->Dim)) continue;
+        
+        const int* nextRuns = index->RowRuns + (size_t)yNext*index->MaxRowRuns;
+        for (int q = FindRowRun(index, yNext, x + reachX); q >= 0 && index->Runs[nextRuns[q]].X1 >= x - reachX; --q)
+        {
+            IndexJoin(index, run, nextRuns[q]);
+        }
+    }
+}
+
+// Finds the region's runs over its band of rows, resets them, and joins them again
+static void IndexSplitRegion(FloodIndex* index, int root)
+{
+    int top = index->Bands[root].Top;
+    int bottom = index->Bands[root].Bottom;
+    FloodContextReserve((void**)&index->Members, &index->MembersCapacity, index->NumRuns, sizeof(int));
+    
+    int numMembers = 0;
+    for (int y = top; y <= bottom; ++y)
+    {
+        const int* rowRuns = index->RowRuns + (size_t)y*index->MaxRowRuns;
+        for (int i = 0; i < index->RowRunCounts[y]; ++i)
+        {
+            if (FindRun(index->Runs, rowRuns[i]) == root) index->Members[numMembers++] = rowRuns[i];
+        }
+    }
+    
+    for (int m = 0; m < numMembers; ++m)
+    {
+        int run = index->Members[m];
+        index->Runs[run].Parent = run;
+        index->Bands[run].Top = index->Bands[run].Bottom = index->Runs[run].Y;
+    }
+    
+    // Other regions in the band never touch this one, so joining whole rows only joins its own runs again
+    for (int y = top + 1; y <= bottom; ++y)
+    {
+        IndexJoinRows(index, y);
+    }
+}
+
+static void IndexCloseCell(FloodIndex* index, int x, int y)
+{
+    index->BitRows[(size_t)y*RowWords(index->Dim) + x/64] &= ~(1llu << (x%64));
+    
+    bool ringOpen[8];
+    for (int k = 0; k < 8; ++k)
+    {
+        ringOpen[k] = IndexCell(index, x + RingX[k], y + RingY[k]);
+    }
+    int reps[8];
+    int numGroups = RingGroups(ringOpen, index->Connectivity == 8, reps);
+    
+    int* rowRuns = index->RowRuns + (size_t)y*index->MaxRowRuns;
+    int p = FindRowRun(index, y, x);
+    int run = rowRuns[p];
+    int root = FindRun(index->Runs, run);
+    int x0 = index->Runs[run].X0;
+    int x1 = index->Runs[run].X1;
+    
+    if (x0 == x1)
+    {
+        memmove(rowRuns + p, rowRuns + p + 1, sizeof(int)*(index->RowRunCounts[y] - p - 1));
+        --index->RowRunCounts[y];
+        ++index->NumDeadRuns;
+    }
+    else if (x == x0)
+    {
+        index->Runs[run].X0 = x + 1;
+    }
+    else if (x == x1)
+    {
+        index->Runs[run].X1 = x - 1;
+    }
+    else
+    {
+        // Both halves stay in the region until a split says otherwise
+        index->Runs[run].X1 = x - 1;
+        int right = IndexNewRun(index, y, x + 1, x1);
+        index->Runs[right].Parent = root;
+        memmove(rowRuns + p + 2, rowRuns + p + 1, sizeof(int)*(index->RowRunCounts[y] - p - 1));
+        rowRuns[p + 1] = right;
+        ++index->RowRunCounts[y];
+    }
+    
+    if (numGroups > 1) IndexSplitRegion(index, root);
+}
+
+void FloodIndexEdit(FloodIndex* index, const FloodEdit* edits, int numEdits)
+{
+    for (int e = 0; e < numEdits; ++e)
+    {
+        int x = edits[e].X;
+        int y = edits[e].Y;
+        if ((x < 0) | (x >= index->Dim) | (y < 0) | (y >= index->Dim)) continue;
+        if (IndexCell(index, x, y) == edits[e].Set) continue;
+        
+        if (index->NumDeadRuns > 64 && 2*index->NumDeadRuns > index->NumRuns) IndexRebuild(index);
+        
+        if (edits[e].Set) IndexOpenCell(index, x, y);
+        else IndexCloseCell(index, x, y);
+    }
+}
+
+int FloodIndexRegionOf(FloodIndex* index, int x, int y)
+{
+    if (!IndexCell(index, x, y)) return -1;
+    
+    int p = FindRowRun(index, y, x);
+    return FindRun(index->Runs, index->RowRuns[(size_t)y*index->MaxRowRuns + p]);
+}
+
+bool FloodIndexSameRegion(FloodIndex* index, int ax, int ay, int bx, int by)
+{
+    int region = FloodIndexRegionOf(index, ax, ay);
+    return region >= 0 && region == FloodIndexRegionOf(index, bx, by);
+}
+
+
+// CPU dispatch
+//
+// One kernel per plane size for each tier, picked from the benchmark. The register deck fill (Flood_8)
+// only beats the carry fill on wide open decks and loses badly on mazes, so the AVX-512 tier keeps
+// the carry fill for 64x64 and only uses AVX-512 code generation for the multi-word rows.
+
+TARGET_BMI2 static int Flood_4_BMI2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return MultiWordSimulSpanFill(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+TARGET_AVX2 static int Flood_4_AVX2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return MultiWordSimulSpanFill(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+TARGET_AVX512 static int Flood_4_AVX512(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return MultiWordSimulSpanFill(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+TARGET_BMI2 static int Flood_5_BMI2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return SimulSpanFill128(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+TARGET_BMI2 static int Flood_7_BMI2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    return CarrySimulSpanFill64(ctx, bitdeck, dim, filled, seedX, seedY);
+}
+
+typedef int (*FloodFn)(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY);
+
+typedef struct
+{
+    FloodTier Tier;
+    FloodFn Fill64;
+    FloodFn Fill128;
+    FloodFn Fill256;
+    FloodFn FillAny;
+} FloodKernels;
+
+static const FloodKernels FloodKernelTiers[FloodTier_Count] =
+{
+    { FloodTier_Scalar, Flood_7, Flood_5, Flood_4, Flood_4 },
+    { FloodTier_BMI2, Flood_7_BMI2, Flood_5_BMI2, Flood_4_BMI2, Flood_4_BMI2 },
+    { FloodTier_AVX2, Flood_7_BMI2, Flood_5_BMI2, SimulSpanFill256, Flood_4_AVX2 },
+    { FloodTier_AVX512, Flood_7_BMI2, Flood_5_BMI2, SimulSpanFill256, Flood_4_AVX512 },
+};
+
+static const FloodKernels* FloodKernelsActive = 0;
+
+static void ResolveFloodKernels()
+{
+    FloodTier tier = FloodTier_Scalar;
+    while (tier+1 < FloodTier_Count && CpuSupportsTier(tier+1))
+    {
+        tier++;
+    }
+    
+    // Forcing a tier is for benchmarking, it can never pick one the host can't run.
+    const char* forced = getenv("FLOODFILL_TIER");
+    if (forced)
+    {
+        for (int t = 0; t < FloodTier_Count; ++t)
+        {
+            if (strcmp(forced, FloodTierName(t)) == 0)
+            {
+                if (CpuSupportsTier(t)) tier = t;
+            }
+        }
+    }
+    
+    FloodKernelsActive = &FloodKernelTiers[tier];
+}
+
+// Resolved exactly once even when the first fills run on several pool workers at the same time
+#ifdef _WIN32
+static INIT_ONCE FloodKernelsOnce = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK ResolveFloodKernelsOnce(PINIT_ONCE once, PVOID arg, PVOID* context)
+{
+    (void)once;
+    (void)arg;
+    (void)context;
+    ResolveFloodKernels();
+    return TRUE;
+}
+#else
+static pthread_once_t FloodKernelsOnce = PTHREAD_ONCE_INIT;
+#endif
+
+void InitializeFloodKernels()
+{
+#ifdef _WIN32
+    InitOnceExecuteOnce(&FloodKernelsOnce, ResolveFloodKernelsOnce, 0, 0);
+#else
+    pthread_once(&FloodKernelsOnce, ResolveFloodKernels);
+#endif
+}
+
+FloodTier FloodActiveTier()
+{
+    InitializeFloodKernels();
+    return FloodKernelsActive->Tier;
+}
+
+int Flood_Dispatch(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    InitializeFloodKernels();
+    
+    switch (dim)
+    {
+        case 64: return FloodKernelsActive->Fill64(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 128: return FloodKernelsActive->Fill128(ctx, bitdeck, dim, filled, seedX, seedY);
+        case 256: return FloodKernelsActive->Fill256(ctx, bitdeck, dim, filled, seedX, seedY);
+        default: return FloodKernelsActive->FillAny(ctx, bitdeck, dim, filled, seedX, seedY);
+    }
+}
+
+
+// Threads
+//
+// Just enough of the platform thread API for the pool: a mutex, a condition variable and threads that
+// get started once and joined when the pool is freed.
+
+static void FloodMutexInit(FloodMutex* mutex)
+{
+#ifdef _WIN32
+    InitializeSRWLock(mutex);
+#else
+    pthread_mutex_init(mutex, 0);
+#endif
+}
+
+static void FloodMutexFree(FloodMutex* mutex)
+{
+#ifdef _WIN32
+    (void)mutex;
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void FloodMutexLock(FloodMutex* mutex)
+{
+#ifdef _WIN32
+    AcquireSRWLockExclusive(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+static void FloodMutexUnlock(FloodMutex* mutex)
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void FloodCondInit(FloodCond* cond)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, 0);
+#endif
+}
+
+static void FloodCondFree(FloodCond* cond)
+{
+#ifdef _WIN32
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+static void FloodCondWait(FloodCond* cond, FloodMutex* mutex)
+{
+#ifdef _WIN32
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+static void FloodCondWakeAll(FloodCond* cond)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+static int FloodHardwareThreads()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+
+// Thread pool
+
+static void FloodPoolWorkerLoop(FloodPoolWorker* worker)
+{
+    FloodPool* pool = worker->Pool;
+    int jobGeneration = 0;
+    
+    FloodMutexLock(&pool->Lock);
+    for (;;)
+    {
+        while (pool->JobGeneration == jobGeneration && !pool->Quit)
+        {
+            FloodCondWait(&pool->WakeCond, &pool->Lock);
+        }
+        if (pool->Quit) break;
+        
+        jobGeneration = pool->JobGeneration;
+        void (*job)(void* arg, int worker) = pool->Job;
+        void* jobArg = pool->JobArg;
+        FloodMutexUnlock(&pool->Lock);
+        
+        job(jobArg, worker->Index);
+        
+        FloodMutexLock(&pool->Lock);
+        if (--pool->WorkersBusy == 0)
+        {
+            FloodCondWakeAll(&pool->DoneCond);
+        }
+    }
+    FloodMutexUnlock(&pool->Lock);
+}
+
+#ifdef _WIN32
+static unsigned long __stdcall FloodPoolThreadMain(void* arg)
+{
+    FloodPoolWorkerLoop((FloodPoolWorker*)arg);
+    return 0;
+}
+#else
+static void* FloodPoolThreadMain(void* arg)
+{
+    FloodPoolWorkerLoop((FloodPoolWorker*)arg);
+    return 0;
+}
+#endif
+
+void FloodPoolInit(FloodPool* pool, int numWorkers)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->NumWorkers = numWorkers > 0 ? numWorkers : FloodHardwareThreads();
+    pool->Workers = calloc(pool->NumWorkers, sizeof(FloodPoolWorker));
+    pool->Contexts = malloc(sizeof(FloodContext)*pool->NumWorkers);
+    FloodMutexInit(&pool->RunLock);
+    FloodMutexInit(&pool->Lock);
+    FloodCondInit(&pool->WakeCond);
+    FloodCondInit(&pool->DoneCond);
+    
+    for (int i = 0; i < pool->NumWorkers; ++i)
+    {
+        FloodPoolWorker* worker = &pool->Workers[i];
+        worker->Pool = pool;
+        worker->Index = i;
+        FloodContextInit(&pool->Contexts[i]);
+        if (i == 0) continue;
+#ifdef _WIN32
+        worker->Thread = CreateThread(0, 0, FloodPoolThreadMain, worker, 0, 0);
+#else
+        pthread_create(&worker->Thread, 0, FloodPoolThreadMain, worker);
+#endif
+    }
+}
+
+void FloodPoolFree(FloodPool* pool)
+{
+    FloodMutexLock(&pool->Lock);
+    pool->Quit = true;
+    FloodCondWakeAll(&pool->WakeCond);
+    FloodMutexUnlock(&pool->Lock);
+    
+    for (int i = 1; i < pool->NumWorkers; ++i)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(pool->Workers[i].Thread, INFINITE);
+        CloseHandle(pool->Workers[i].Thread);
+#else
+        pthread_join(pool->Workers[i].Thread, 0);
+#endif
+    }
+    
+    FloodCondFree(&pool->DoneCond);
+    FloodCondFree(&pool->WakeCond);
+    FloodMutexFree(&pool->Lock);
+    FloodMutexFree(&pool->RunLock);
+    for (int i = 0; i < pool->NumWorkers; ++i)
+    {
+        FloodContextFree(&pool->Contexts[i]);
+    }
+    free(pool->Contexts);
+    free(pool->Workers);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void FloodPoolRun(FloodPool* pool, void (*job)(void* arg, int worker), void* arg)
+{
+    FloodMutexLock(&pool->RunLock);
+    
+    FloodMutexLock(&pool->Lock);
+    pool->Job = job;
+    pool->JobArg = arg;
+    pool->WorkersBusy = pool->NumWorkers - 1;
+    pool->JobGeneration++;
+    FloodCondWakeAll(&pool->WakeCond);
+    FloodMutexUnlock(&pool->Lock);
+    
+    job(arg, 0);
+    
+    FloodMutexLock(&pool->Lock);
+    while (pool->WorkersBusy)
+    {
+        FloodCondWait(&pool->DoneCond, &pool->Lock);
+    }
+    FloodMutexUnlock(&pool->Lock);
+    
+    FloodMutexUnlock(&pool->RunLock);
+}
+
+
+// Fill jobs
+//
+// Jobs are claimed in chunks from one shared counter, so the lock is taken once per chunk rather than
+// once per fill. A chunk holds about FLOOD_JOB_CHUNK_BYTES of decks and fills, so a worker's decks stay
+// in its own cache while it fills them, but batches are still cut into a few chunks per worker so a
+// worker stuck on slow fills doesn't hold up the rest.
+
+typedef struct
+{
+    FloodPool* Pool;
+    FloodJob* Jobs;
+    int NumJobs;
+    int ChunkSize;
+    int Connectivity;
+    void (*Done)(FloodJob* job, void* arg);
+    void* DoneArg;
+    FloodMutex Lock;
+    int NextJob;
+} FloodJobBatch;
+
+static void RunFloodJobs(void* arg, int worker)
+{
+    FloodJobBatch* batch = (FloodJobBatch*)arg;
+    FloodContext* ctx = &batch->Pool->Contexts[worker];
+    ctx->Connectivity = batch->Connectivity;
+    
+    for (;;)
+    {
+        FloodMutexLock(&batch->Lock);
+        int first = batch->NextJob;
+        batch->NextJob = first + batch->ChunkSize < batch->NumJobs ? first + batch->ChunkSize : batch->NumJobs;
+        int last = batch->NextJob;
+        FloodMutexUnlock(&batch->Lock);
+        if (first == last) break;
+        
+        for (int i = first; i < last; ++i)
+        {
+            FloodJob* job = &batch->Jobs[i];
+            job->NumFilled = Flood_Dispatch(ctx, job->Bitdeck, job->Dim, job->Filled, job->SeedX, job->SeedY);
+            if (batch->Done) batch->Done(job, batch->DoneArg);
+        }
+    }
+}
+
+void FloodJobsRun(FloodPool* pool, int connectivity, FloodJob* jobs, int numJobs, void (*done)(FloodJob* job, void* arg), void* doneArg)
+{
+    if (numJobs <= 0) return;
+    
+    // Chunks by the average deck and fill of the batch
+    uint64 totalBytes = 0;
+    for (int i = 0; i < numJobs; ++i)
+    {
+        totalBytes += 2*((uint64)jobs[i].Dim*jobs[i].Dim + 7)/8;
+    }
+    uint64 jobBytes = totalBytes/numJobs > 0 ? totalBytes/numJobs : 1;
+    int chunkSize = jobBytes < FLOOD_JOB_CHUNK_BYTES ? (int)(FLOOD_JOB_CHUNK_BYTES/jobBytes) : 1;
+    int balancedSize = (numJobs + 4*pool->NumWorkers - 1)/(4*pool->NumWorkers);
+    
+    FloodJobBatch batch;
+    batch.Pool = pool;
+    batch.Jobs = jobs;
+    batch.NumJobs = numJobs;
+    batch.ChunkSize = chunkSize < balancedSize ? chunkSize : balancedSize;
+    batch.Connectivity = connectivity;
+    batch.Done = done;
+    batch.DoneArg = doneArg;
+    batch.NextJob = 0;
+    FloodMutexInit(&batch.Lock);
+    
+    FloodPoolRun(pool, RunFloodJobs, &batch);
+    
+    FloodMutexFree(&batch.Lock);
+}
+
+
+// Occupancy summary
+//
+// One open cell count per 64x64 block. A count of zero is an empty block and a count of every cell in
+// the block is a full one, so the state needs no scan, and an edit only moves one count up or down.
+// Blocks line up with the tiles of Flood_Tiled: an empty block never takes seeds, and a full block that
+// takes any is filled whole and marked complete, after which seeds for it are dropped without queueing
+// it again. On open planes that turns most of the fill into stores, and each tile is visited once.
+// A second level over the blocks wouldn't pay: the tile queue already only visits blocks the region
+// reaches.
+
+void FloodSummaryInit(FloodSummary* summary)
+{
+    memset(summary, 0, sizeof(*summary));
+}
+
+void FloodSummaryFree(FloodSummary* summary)
+{
+    free(summary->Counts);
+    memset(summary, 0, sizeof(*summary));
+}
+
+void FloodSummaryBuild(FloodSummary* summary, const uint8* bitdeck, int dim)
+{
+    int blocksAcross = (dim + 63)/64;
+    summary->Dim = dim;
+    summary->BlocksAcross = blocksAcross;
+    FloodContextReserve((void**)&summary->Counts, &summary->CountsCapacity, (size_t)blocksAcross*blocksAcross, sizeof(uint16));
+    memset(summary->Counts, 0, sizeof(uint16)*blocksAcross*blocksAcross);
+    
+    for (int y = 0; y < dim; ++y)
+    {
+        uint16* blockCounts = summary->Counts + (size_t)(y/64)*blocksAcross;
+        for (int w = 0; w < blocksAcross; ++w)
+        {
+            uint64 bits = dim % 64 == 0 ?
+                ((const uint64*)bitdeck)[(size_t)y*blocksAcross + w] :
+                LoadBits(bitdeck, (size_t)y*dim + w*64, dim - w*64 < 64 ? dim - w*64 : 64);
+            blockCounts[w] += (uint16)CountBits(bits);
+        }
+    }
+}
+
+void FloodSummaryEdit(FloodSummary* summary, uint8* bitdeck, const FloodEdit* edits, int numEdits)
+{
+    int dim = summary->Dim;
+    for (int e = 0; e < numEdits; ++e)
+    {
+        int x = edits[e].X;
+        int y = edits[e].Y;
+        if ((x < 0) | (x >= dim) | (y < 0) | (y >= dim)) continue;
+        if (DeckCell(bitdeck, dim, x, y) == edits[e].Set) continue;
+        
+        WriteDeckCell(bitdeck, dim, x, y, edits[e].Set);
+        summary->Counts[(size_t)(y/64)*summary->BlocksAcross + x/64] += edits[e].Set ? 1 : -1;
+    }
+}
+
+FloodBlockState FloodSummaryBlock(const FloodSummary* summary, int blockX, int blockY)
+{
+    int width = summary->Dim - blockX*64 < 64 ? summary->Dim - blockX*64 : 64;
+    int height = summary->Dim - blockY*64 < 64 ? summary->Dim - blockY*64 : 64;
+    int count = summary->Counts[(size_t)blockY*summary->BlocksAcross + blockX];
+    if (count == 0) return FloodBlock_Empty;
+    return count == width*height ? FloodBlock_Full : FloodBlock_Mixed;
+}
+
+
+// Tiled fill
+//
+// A plane of whole 64 bit rows splits into 64x64 tiles, one word of each of 64 rows, so tiles never
+// share a word of 'filled' and can be filled at the same time without locking the deck. A tile is
+// filled with the Flood_7 kernel on a local copy of its rows. Cells it fills on its edges are handed
+// to the neighbouring tile as seeds: a column of 64 bits for the left and right neighbours, a row for
+// the ones above and below. Seeds that came in from a side are never handed back to that side, since
+// their neighbour there is already filled. With 8-connectivity the edges are widened by one cell before
+// they're handed over, corner cells are also handed to the diagonal neighbours, and seeds are handed
+// back, since a cell seeded diagonally can still have open neighbours on that side.
+//
+// A tile is idle, queued or running. Seeds arriving for a running tile mark it dirty and it's queued
+// again when it finishes, so a tile is only ever processed by one worker at a time. Workers queue the
+// tiles they discover on their own ring and take from its back, and steal from the front of the other
+// rings when theirs is empty. The fill has converged when no tile is queued or running, and since it
+// only ever grows along connected open cells, the result is the same region the single threaded
+// fills produce.
+
+typedef enum
+{
+    FloodTile_Idle,
+    FloodTile_Queued,
+    FloodTile_Running,
+    FloodTile_RunningDirty,
+} FloodTileState;
+
+typedef struct FloodTile
+{
+    uint64 Left;        // Seeds entering through column 0, one bit per row
+    uint64 Right;       // Seeds entering through column 63, one bit per row
+    uint64 Top;         // Seeds entering through row 0
+    uint64 Bottom;      // Seeds entering through row 63
+    FloodTileState State;
+    bool Complete;      // Every cell filled, only ever set for full blocks of the summary
+} FloodTile;
+
+typedef struct
+{
+    int* Items;
+    int Head;
+    int Count;
+} FloodTileQueue;
+
+typedef struct
+{
+    const uint64* BitRows;
+    uint64* FillRows;
+    int RowWords;       // Also the number of tiles across
+    int TilesDown;
+    FloodTile* Tiles;
+    FloodTileQueue* Queues;
+    int NumQueues;
+    FloodMutex Lock;
+    FloodCond WorkCond;
+    int Outstanding;    // Tiles queued or running
+    int Waiting;        // Workers asleep on WorkCond
+    int NumFilled;
+    uint64 Diagonals;   // FloodDiagonals() of the context
+    const FloodSummary* Summary;
+} TiledFill;
+
+static void PushTile(TiledFill* fill, int worker, int tile)
+{
+    FloodTileQueue* queue = &fill->Queues[worker];
+    int numTiles = fill->RowWords*fill->TilesDown;
+    queue->Items[(queue->Head + queue->Count) % numTiles] = tile;
+    queue->Count++;
+}
+
+// Own queue from the back, LIFO keeps the worker near the tiles it just filled. Others from the front.
+static int TakeTile(TiledFill* fill, int worker)
+{
+    int numTiles = fill->RowWords*fill->TilesDown;
+    FloodTileQueue* own = &fill->Queues[worker];
+    if (own->Count)
+    {
+        own->Count--;
+        return own->Items[(own->Head + own->Count) % numTiles];
+    }
+    for (int i = 1; i < fill->NumQueues; ++i)
+    {
+        FloodTileQueue* victim = &fill->Queues[(worker + i) % fill->NumQueues];
+        if (victim->Count)
+        {
+            int tile = victim->Items[victim->Head];
+            victim->Head = (victim->Head + 1) % numTiles;
+            victim->Count--;
+            return tile;
+        }
+    }
+    return -1;
+}
+
+// Adds seeds to a tile and queues it if it isn't already. Call with the lock held.
+static void PostTileSeeds(TiledFill* fill, int worker, int tile, uint64 left, uint64 right, uint64 top, uint64 bottom)
+{
+    if (!(left | right | top | bottom)) return;
+    if (fill->Summary && !fill->Summary->Counts[tile]) return;
+    
+    FloodTile* t = &fill->Tiles[tile];
+    if (t->Complete) return;
+    t->Left |= left;
+    t->Right |= right;
+    t->Top |= top;
+    t->Bottom |= bottom;
+    
+    if (t->State == FloodTile_Idle)
+    {
+        t->State = FloodTile_Queued;
+        fill->Outstanding++;
+        PushTile(fill, worker, tile);
+        if (fill->Waiting) FloodCondWakeAll(&fill->WorkCond);
+    }
+    else if (t->State == FloodTile_Running)
+    {
+        t->State = FloodTile_RunningDirty;
+    }
+}
+
+// FillTile for a block the summary says is full: any seed that isn't filled yet fills the whole tile,
+// without reading the plane or running the kernel.
+static int FillFullTile(TiledFill* fill, uint64* fillTile, const uint64* seeds, const FloodTile* seededFrom, FloodTile* edges, bool* complete)
+{
+    int rowWords = fill->RowWords;
+    uint64 seeded = 0;
+    uint64 leftBefore = 0;
+    uint64 rightBefore = 0;
+    int numFilled = 0;
+    for (int r = 0; r < 64; ++r)
+    {
+        uint64 fillRow = fillTile[(size_t)r*rowWords];
+        seeded |= seeds[r] & ~fillRow;
+        leftBefore |= (fillRow & 1) << r;
+        rightBefore |= (fillRow >> 63) << r;
+        numFilled += 64 - (int)CountBits(fillRow);
+    }
+    if (!seeded) return 0;
+    
+    uint64 handBack = fill->Diagonals;
+    edges->Left = ~leftBefore & ~(seededFrom->Left & ~handBack);
+    edges->Right = ~rightBefore & ~(seededFrom->Right & ~handBack);
+    edges->Top = ~fillTile[0] & ~(seededFrom->Top & ~handBack);
+    edges->Bottom = ~fillTile[(size_t)63*rowWords] & ~(seededFrom->Bottom & ~handBack);
+    
+    for (int r = 0; r < 64; ++r)
+    {
+        fillTile[(size_t)r*rowWords] = ~0llu;
+    }
+    *complete = true;
+    return numFilled;
+}
+
+// Fills one tile from seed rows, and returns the cells filled on each edge that weren't seeded from that
+// side in 'edges'. 'complete' is set when a full block was filled whole. Returns the number of newly
+// filled cells.
+static int FillTile(TiledFill* fill, int tile, const uint64* seeds, const FloodTile* seededFrom, FloodTile* edges, bool* complete)
+{
+    int rowWords = fill->RowWords;
+    size_t firstWord = (size_t)(tile / rowWords)*64*rowWords + tile % rowWords;
+    const uint64* bitTile = fill->BitRows + firstWord;
+    uint64* fillTile = fill->FillRows + firstWord;
+    
+    if (fill->Summary && fill->Summary->Counts[tile] == 64*64)
+    {
+        return FillFullTile(fill, fillTile, seeds, seededFrom, edges, complete);
+    }
+    
+    // Seeds are often already filled by the time the tile runs, check them before copying the tile in
+    uint64 seedRows = 0;
+    for (int r = 0; r < 64; ++r)
+    {
+        if (seeds[r] & bitTile[(size_t)r*rowWords] & ~fillTile[(size_t)r*rowWords])
+        {
+            seedRows |= 1llu << r;
+        }
+    }
+    if (!seedRows) return 0;
+    
+    uint64 bitRows[64];
+    uint64 fillRows[64];
+    for (int r = 0; r < 64; ++r)
+    {
+        bitRows[r] = bitTile[(size_t)r*rowWords];
+        fillRows[r] = fillTile[(size_t)r*rowWords];
+    }
+    
+    uint64 leftBefore = 0;
+    uint64 rightBefore = 0;
+    for (int r = 0; r < 64; ++r)
+    {
+        leftBefore |= (fillRows[r] & 1) << r;
+        rightBefore |= (fillRows[r] >> 63) << r;
+    }
+    uint64 topBefore = fillRows[0];
+    uint64 bottomBefore = fillRows[63];
+    
+    int stack[64];
+    int stackCount = 0;
+    int numFilled = 0;
+    uint64 pending = seedRows;
+    while (pending)
+    {
+        int r = LowestBit(pending);
+        pending &= pending - 1;
+        uint64 newFill = seeds[r] & bitRows[r] & ~fillRows[r];
+        fillRows[r] |= newFill;
+        numFilled += (int)CountBits(newFill);
+        stack[stackCount++] = r;
+    }
+    numFilled += CarrySpanFillRows(bitRows, 0, fillRows, 64, stack, stackCount, seedRows, fill->Diagonals, 0);
+    
+    uint64 leftAfter = 0;
+    uint64 rightAfter = 0;
+    for (int r = 0; r < 64; ++r)
+    {
+        fillTile[(size_t)r*rowWords] = fillRows[r];
+        leftAfter |= (fillRows[r] & 1) << r;
+        rightAfter |= (fillRows[r] >> 63) << r;
+    }
+    
+    uint64 handBack = fill->Diagonals;
+    edges->Left = leftAfter & ~leftBefore & ~(seededFrom->Left & ~handBack);
+    edges->Right = rightAfter & ~rightBefore & ~(seededFrom->Right & ~handBack);
+    edges->Top = fillRows[0] & ~topBefore & ~(seededFrom->Top & ~handBack);
+    edges->Bottom = fillRows[63] & ~bottomBefore & ~(seededFrom->Bottom & ~handBack);
+    return numFilled;
+}
+
+// Hands a filled tile's edges to its neighbours. Call with the lock held.
+static void PostTileEdges(TiledFill* fill, int worker, int tile, const FloodTile* edges)
+{
+    int tileX = tile % fill->RowWords;
+    int tileY = tile / fill->RowWords;
+    int rowWords = fill->RowWords;
+    bool left = tileX > 0;
+    bool right = tileX < rowWords-1;
+    bool up = tileY > 0;
+    bool down = tileY < fill->TilesDown-1;
+    uint64 d = fill->Diagonals;
+    
+    // Column masks have one bit per row, so the same widening works for them
+    if (left) PostTileSeeds(fill, worker, tile - 1, 0, ReachRow(edges->Left, d), 0, 0);
+    if (right) PostTileSeeds(fill, worker, tile + 1, ReachRow(edges->Right, d), 0, 0, 0);
+    if (up) PostTileSeeds(fill, worker, tile - rowWords, 0, 0, 0, ReachRow(edges->Top, d));
+    if (down) PostTileSeeds(fill, worker, tile + rowWords, 0, 0, ReachRow(edges->Bottom, d), 0);
+    
+    // Corner cells touch the diagonal neighbours' opposite corners
+    if (d)
+    {
+        if (left && up) PostTileSeeds(fill, worker, tile - rowWords - 1, 0, 0, 0, (edges->Left & 1) << 63);
+        if (right && up) PostTileSeeds(fill, worker, tile - rowWords + 1, 0, 0, 0, edges->Right & 1);
+        if (left && down) PostTileSeeds(fill, worker, tile + rowWords - 1, 0, 0, (edges->Left >> 63) << 63, 0);
+        if (right && down) PostTileSeeds(fill, worker, tile + rowWords + 1, 0, 0, edges->Right >> 63, 0);
+    }
+}
+
+static void TiledFillWorker(void* arg, int worker)
+{
+    TiledFill* fill = (TiledFill*)arg;
+    int numFilled = 0;
+    worker %= fill->NumQueues;
+    
+    FloodMutexLock(&fill->Lock);
+    for (;;)
+    {
+        int tile = TakeTile(fill, worker);
+        if (tile < 0)
+        {
+            if (fill->Outstanding == 0) break;
+            fill->Waiting++;
+            FloodCondWait(&fill->WorkCond, &fill->Lock);
+            fill->Waiting--;
+            continue;
+        }
+        
+        FloodTile* t = &fill->Tiles[tile];
+        FloodTile seededFrom = *t;
+        t->Left = t->Right = t->Top = t->Bottom = 0;
+        t->State = FloodTile_Running;
+        FloodMutexUnlock(&fill->Lock);
+        
+        uint64 seeds[64];
+        for (int r = 0; r < 64; ++r)
+        {
+            seeds[r] = ((seededFrom.Left >> r) & 1) | (((seededFrom.Right >> r) & 1) << 63);
+        }
+        seeds[0] |= seededFrom.Top;
+        seeds[63] |= seededFrom.Bottom;
+        
+        FloodTile edges;
+        bool complete = false;
+        int tileFilled = FillTile(fill, tile, seeds, &seededFrom, &edges, &complete);
+        numFilled += tileFilled;
+        
+        FloodMutexLock(&fill->Lock);
+        t->Complete |= complete;
+        if (tileFilled)
+        {
+            PostTileEdges(fill, worker, tile, &edges);
+        }
+        if (t->State == FloodTile_RunningDirty && !t->Complete)
+        {
+            t->State = FloodTile_Queued;
+            PushTile(fill, worker, tile);
+        }
+        else
+        {
+            t->State = FloodTile_Idle;
+            if (--fill->Outstanding == 0 && fill->Waiting)
+            {
+                FloodCondWakeAll(&fill->WorkCond);
+            }
+        }
+    }
+    fill->NumFilled += numFilled;
+    FloodMutexUnlock(&fill->Lock);
+}
+
+int Flood_Tiled(FloodContext* ctx, FloodPool* pool, const FloodSummary* summary, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY)
+{
+    if (!pool || dim % 64 != 0) return Flood_Dispatch(ctx, bitdeck, dim, filled, seedX, seedY);
+    if (TestCell(bitdeck, dim, filled, seedX, seedY) < 0) return 0;
+    if (summary && summary->Dim != dim) summary = 0;
+    
+    TiledFill fill;
+    memset(&fill, 0, sizeof(fill));
+    fill.BitRows = (const uint64*)bitdeck;
+    fill.FillRows = (uint64*)filled;
+    fill.RowWords = dim/64;
+    fill.TilesDown = dim/64;
+    fill.Diagonals = FloodDiagonals(ctx);
+    fill.Summary = summary;
+    
+    int numTiles = fill.RowWords*fill.TilesDown;
+    fill.Tiles = FloodContextReserve((void**)&ctx->Tiles, &ctx->TilesCapacity, numTiles, sizeof(FloodTile));
+    memset(fill.Tiles, 0, sizeof(FloodTile)*numTiles);
+    
+    FloodTileQueue queues[64];
+    fill.NumQueues = pool->NumWorkers < 64 ? pool->NumWorkers : 64;
+    int* queueItems = FloodContextReserve((void**)&ctx->TileQueues, &ctx->TileQueuesCapacity, (size_t)numTiles*fill.NumQueues, sizeof(int));
+    for (int i = 0; i < fill.NumQueues; ++i)
+    {
+        queues[i].Items = queueItems + (size_t)i*numTiles;
+        queues[i].Head = 0;
+        queues[i].Count = 0;
+    }
+    fill.Queues = queues;
+    FloodMutexInit(&fill.Lock);
+    FloodCondInit(&fill.WorkCond);
+    
+    // The seed tile is filled here, then the pool picks up whatever spills out of it
+    int seedTile = (seedY/64)*fill.RowWords + seedX/64;
+    uint64 seeds[64] = { 0 };
+    seeds[seedY%64] = 1llu << (seedX%64);
+    FloodTile seededFrom = { 0 };
+    FloodTile edges;
+    bool complete = false;
+    int numFilled = FillTile(&fill, seedTile, seeds, &seededFrom, &edges, &complete);
+    fill.Tiles[seedTile].Complete = complete;
+    
+    PostTileEdges(&fill, 0, seedTile, &edges);
+    if (fill.Outstanding)
+    {
+        FloodPoolRun(pool, TiledFillWorker, &fill);
+    }
+    
+    FloodCondFree(&fill.WorkCond);
+    FloodMutexFree(&fill.Lock);
+    
+    return numFilled + fill.NumFilled;
+}
+
+
+// Plane files
+//
+// Just enough of the platform file mapping API to map any range of rows of a plane file. Views start
+// at the mapping granularity below the first byte asked for, so rows need no alignment in the file
+// beyond whole words.
+
+static size_t PlaneMapGranularity()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+// Maps bytes offset..offset+length of the file. Returns a pointer to 'offset', or null on failure.
+static void* MapPlaneBytes(FloodPlaneFile* plane, uint64 offset, size_t length, FloodPlaneView* view)
+{
+    uint64 start = offset - offset % PlaneMapGranularity();
+    view->Length = (size_t)(offset - start) + length;
+#ifdef _WIN32
+    view->Base = MapViewOfFile(plane->Mapping, plane->Writable ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)start, view->Length);
+#else
+    view->Base = mmap(0, view->Length, PROT_READ | (plane->Writable ? PROT_WRITE : 0), MAP_SHARED, plane->File, (off_t)start);
+    if (view->Base == MAP_FAILED) view->Base = 0;
+#endif
+    return view->Base ? (uint8*)view->Base + (offset - start) : 0;
+}
+
+static void UnmapPlaneBytes(FloodPlaneView* view)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(view->Base);
+#else
+    munmap(view->Base, view->Length);
+#endif
+    view->Base = 0;
+}
+
+// The view is about to be read front to back, so start reading it in now and drop pages behind us
+static void AdvisePlaneView(const FloodPlaneView* view)
+{
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range = { view->Base, view->Length };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    madvise(view->Base, view->Length, MADV_SEQUENTIAL);
+    madvise(view->Base, view->Length, MADV_WILLNEED);
+#endif
+}
+
+// Opens the file and its mapping, with fileSize 0 opening an existing file as is and anything else
+// creating or truncating it to that size
+static bool OpenPlaneMapping(FloodPlaneFile* plane, const char* path, bool writable, uint64 fileSize, uint64* sizeOut)
+{
+    memset(plane, 0, sizeof(*plane));
+    plane->Writable = writable;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ | (writable ? GENERIC_WRITE : 0), FILE_SHARE_READ, 0,
+        fileSize ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)fileSize;
+    if (fileSize && !(SetFilePointerEx(file, size, 0, FILE_BEGIN) && SetEndOfFile(file)))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    GetFileSizeEx(file, &size);
+    *sizeOut = (uint64)size.QuadPart;
+    
+    plane->File = file;
+    plane->Mapping = *sizeOut ? CreateFileMappingA(file, 0, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, 0) : 0;
+    if (!plane->Mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+#else
+    int file = open(path, (writable ? O_RDWR : O_RDONLY) | (fileSize ? O_CREAT | O_TRUNC : 0), 0644);
+    if (file < 0) return false;
+    
+    struct stat info;
+    if ((fileSize && ftruncate(file, (off_t)fileSize) != 0) || fstat(file, &info) != 0)
+    {
+        close(file);
+        return false;
+    }
+    *sizeOut = (uint64)info.st_size;
+    plane->File = file;
+#endif
+    return true;
+}
+
+void FloodPlaneClose(FloodPlaneFile* plane)
+{
+#ifdef _WIN32
+    if (plane->Mapping) CloseHandle(plane->Mapping);
+    if (plane->File) CloseHandle(plane->File);
+#else
+    if (plane->File > 0) close(plane->File);
+#endif
+    memset(plane, 0, sizeof(*plane));
+}
+
+bool FloodPlaneCreate(FloodPlaneFile* plane, const char* path, int width, int height)
+{
+    if (width <= 0 || height <= 0) return false;
+    
+    FloodPlaneHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Magic = FLOOD_PLANE_MAGIC;
+    header.Version = FLOOD_PLANE_VERSION_RAW;
+    header.Width = (uint64)width;
+    header.Height = (uint64)height;
+    header.RowStride = (uint64)RowWords(width)*sizeof(uint64);
+    header.DataOffset = (sizeof(header) + 63) & ~(uint64)63;
+    
+    uint64 fileSize;
+    if (!OpenPlaneMapping(plane, path, true, header.DataOffset + header.RowStride*header.Height, &fileSize)) return false;
+    
+    FloodPlaneView view;
+    void* headerBytes = MapPlaneBytes(plane, 0, sizeof(header), &view);
+    if (!headerBytes)
+    {
+        FloodPlaneClose(plane);
+        return false;
+    }
+    memcpy(headerBytes, &header, sizeof(header));
+    UnmapPlaneBytes(&view);
+    
+    plane->Header = header;
+    return true;
+}
+
+bool FloodPlaneOpen(FloodPlaneFile* plane, const char* path, bool writable)
+{
+    uint64 fileSize;
+    if (!OpenPlaneMapping(plane, path, writable, 0, &fileSize)) return false;
+    
+    FloodPlaneView view;
+    const void* headerBytes = fileSize >= sizeof(FloodPlaneHeader) ? MapPlaneBytes(plane, 0, sizeof(FloodPlaneHeader), &view) : 0;
+    if (!headerBytes)
+    {
+        FloodPlaneClose(plane);
+        return false;
+    }
+    FloodPlaneHeader header;
+    memcpy(&header, headerBytes, sizeof(header));
+    UnmapPlaneBytes(&view);
+    
+    // Rows must be whole words that the kernels can walk in place
+    bool valid = header.Magic == FLOOD_PLANE_MAGIC && header.Version == FLOOD_PLANE_VERSION_RAW &&
+        header.Width >= 1 && header.Width <= INT_MAX && header.Height >= 1 && header.Height <= INT_MAX &&
+        header.RowStride % sizeof(uint64) == 0 && header.RowStride >= (uint64)RowWords((int)header.Width)*sizeof(uint64) &&
+        header.DataOffset % sizeof(uint64) == 0 && header.DataOffset >= sizeof(header) &&
+        (fileSize - header.DataOffset)/header.RowStride >= header.Height;
+    if (!valid || fileSize < header.DataOffset)
+    {
+        FloodPlaneClose(plane);
+        return false;
+    }
+    
+    plane->Header = header;
+    return true;
+}
+
+uint64* FloodPlaneMapRows(FloodPlaneFile* plane, int firstRow, int numRows, FloodPlaneView* view)
+{
+    const FloodPlaneHeader* header = &plane->Header;
+    return MapPlaneBytes(plane, header->DataOffset + (uint64)firstRow*header->RowStride, (size_t)numRows*header->RowStride, view);
+}
+
+void FloodPlaneUnmap(FloodPlaneView* view)
+{
+    UnmapPlaneBytes(view);
+}
+
+
+// Compressed plane files
+//
+// Each row is a tag byte and its body. Rows with no cells or every cell set are the tag alone. Other
+// rows are a count of the places the row changes between clear and set, then the distance from each
+// change to the next as a varint, or the raw words when those would take more room. Changes are found
+// a word at a time as bits ^ (bits << 1 | carry), so encoding costs a popcount per word and a varint per
+// change. Decoding writes each set run as whole word masks straight into the padded rows.
+
+enum
+{
+    PlaneRow_Clear,
+    PlaneRow_Set,
+    PlaneRow_Changes,
+    PlaneRow_Raw,
+};
+
+// Largest varint of a distance along a row of up to INT_MAX cells
+#define FLOOD_ROW_VARINT_BYTES 5
+
+static FORCE_INLINE size_t PutVarint(uint8* out, uint64 value)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8)value;
+    return n;
+}
+
+// Returns the byte after the varint, or null when it runs past 'end' or 64 bits
+static FORCE_INLINE const uint8* GetVarint(const uint8* in, const uint8* end, uint64* value)
+{
+    uint64 result = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7)
+    {
+        uint8 byte = *in++;
+        result |= (uint64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return in;
+        }
+    }
+    return 0;
+}
+
+// Sets bits lo..hi-1 of a row
+static FORCE_INLINE void SetRowRun(uint64* row, uint64 lo, uint64 hi)
+{
+    if (lo >= hi) return;
+    
+    size_t first = lo/64;
+    size_t last = (hi - 1)/64;
+    uint64 lowMask = ~0llu << (lo%64);
+    uint64 highMask = ~0llu >> (63 - (hi - 1)%64);
+    if (first == last)
+    {
+        row[first] |= lowMask & highMask;
+        return;
+    }
+    row[first] |= lowMask;
+    for (size_t w = first + 1; w < last; ++w) row[w] = ~0llu;
+    row[last] |= highMask;
+}
+
+// Encodes one row into 'out', which has room for the tag and the raw words. Returns the bytes written.
+// Bits of the last word past the row end are dropped, the decoder would take them for a broken row.
+static FORCE_INLINE size_t EncodePlaneRow(const uint64* row, int rowWords, uint64 lastMask, uint8* out)
+{
+    size_t rawBytes = (size_t)rowWords*sizeof(uint64);
+    uint64 numChanges = 0;
+    uint64 carry = 0;
+    bool set = true;
+    for (int w = 0; w < rowWords; ++w)
+    {
+        uint64 mask = w == rowWords-1 ? lastMask : ~0llu;
+        uint64 bits = row[w] & mask;
+        numChanges += CountBits(bits ^ ((bits << 1) | carry));
+        carry = bits >> 63;
+        set &= bits == mask;
+    }
+    
+    if (numChanges == 0 || set)
+    {
+        out[0] = numChanges ? PlaneRow_Set : PlaneRow_Clear;
+        return 1;
+    }
+    
+    // Every change takes at least a byte, so only rows with few of them are worth trying
+    if (numChanges + FLOOD_ROW_VARINT_BYTES < rawBytes)
+    {
+        size_t n = 1 + PutVarint(out + 1, numChanges);
+        uint64 position = 0;
+        carry = 0;
+        for (int w = 0; w < rowWords && n + FLOOD_ROW_VARINT_BYTES <= rawBytes; ++w)
+        {
+            uint64 bits = row[w] & (w == rowWords-1 ? lastMask : ~0llu);
+            uint64 changes = bits ^ ((bits << 1) | carry);
+            carry = bits >> 63;
+            while (changes && n + FLOOD_ROW_VARINT_BYTES <= rawBytes)
+            {
+                uint64 x = (uint64)w*64 + LowestBit(changes);
+                n += PutVarint(out + n, x - position);
+                position = x;
+                changes &= changes - 1;
+            }
+            if (w == rowWords-1 && !changes)
+            {
+                out[0] = PlaneRow_Changes;
+                return n;
+            }
+        }
+    }
+    
+    uint64 last = row[rowWords-1] & lastMask;
+    out[0] = PlaneRow_Raw;
+    memcpy(out + 1, row, rawBytes - sizeof(uint64));
+    memcpy(out + 1 + rawBytes - sizeof(uint64), &last, sizeof(uint64));
+    return 1 + rawBytes;
+}
+
+// Decodes one row from 'in'. Returns the byte after it, or null when the row doesn't make sense.
+static FORCE_INLINE const uint8* DecodePlaneRow(const uint8* in, const uint8* end, uint64* row, int rowWords, uint64 width, uint64 lastMask)
+{
+    size_t rawBytes = (size_t)rowWords*sizeof(uint64);
+    if (in >= end) return 0;
+    
+    switch (*in++)
+    {
+        case PlaneRow_Clear:
+            memset(row, 0, rawBytes);
+            return in;
+        case PlaneRow_Set:
+            memset(row, 0xff, rawBytes);
+            row[rowWords-1] = lastMask;
+            return in;
+        case PlaneRow_Raw:
+            if ((size_t)(end - in) < rawBytes) return 0;
+            memcpy(row, in, rawBytes);
+            row[rowWords-1] &= lastMask;
+            return in + rawBytes;
+        case PlaneRow_Changes:
+            break;
+        default:
+            return 0;
+    }
+    
+    // Changes alternate between starting and ending a set run, and the last run may reach the row end
+    uint64 numChanges;
+    in = GetVarint(in, end, &numChanges);
+    if (!in || numChanges > width + 1) return 0;
+    
+    memset(row, 0, rawBytes);
+    uint64 position = 0;
+    for (uint64 i = 0; i < numChanges; ++i)
+    {
+        uint64 distance;
+        in = GetVarint(in, end, &distance);
+        if (!in || distance > width - position) return 0;
+        if (i & 1) SetRowRun(row, position, position + distance);
+        position += distance;
+    }
+    if (numChanges & 1) SetRowRun(row, position, width);
+    return in;
+}
+
+// Encodes rows into 'out' until it's down to less than a row of room. Returns the number of rows taken.
+static FORCE_INLINE int EncodePlaneRows(const uint64* rows, int rowWords, uint64 lastMask, int numRows, uint8* out, size_t capacity, size_t* size)
+{
+    size_t rowBytes = 1 + (size_t)rowWords*sizeof(uint64);
+    size_t n = 0;
+    int r = 0;
+    for (; r < numRows && n + rowBytes <= capacity; ++r)
+    {
+        n += EncodePlaneRow(rows + (size_t)r*rowWords, rowWords, lastMask, out + n);
+    }
+    *size = n;
+    return r;
+}
+
+static FORCE_INLINE bool DecodePlaneRows(const uint8* in, const uint8* end, uint64* rows, int rowWords, uint64 width, uint64 lastMask, int numRows)
+{
+    for (int r = 0; r < numRows && in; ++r)
+    {
+        in = DecodePlaneRow(in, end, rows + (size_t)r*rowWords, rowWords, width, lastMask);
+    }
+    return in != 0;
+}
+
+static int EncodePlaneRowsBaseline(const uint64* rows, int rowWords, uint64 lastMask, int numRows, uint8* out, size_t capacity, size_t* size)
+{
+    return EncodePlaneRows(rows, rowWords, lastMask, numRows, out, capacity, size);
+}
+
+TARGET_BMI2 static int EncodePlaneRows_BMI2(const uint64* rows, int rowWords, uint64 lastMask, int numRows, uint8* out, size_t capacity, size_t* size)
+{
+    return EncodePlaneRows(rows, rowWords, lastMask, numRows, out, capacity, size);
+}
+
+static bool DecodePlaneRowsBaseline(const uint8* in, const uint8* end, uint64* rows, int rowWords, uint64 width, uint64 lastMask, int numRows)
+{
+    return DecodePlaneRows(in, end, rows, rowWords, width, lastMask, numRows);
+}
+
+TARGET_BMI2 static bool DecodePlaneRows_BMI2(const uint8* in, const uint8* end, uint64* rows, int rowWords, uint64 width, uint64 lastMask, int numRows)
+{
+    return DecodePlaneRows(in, end, rows, rowWords, width, lastMask, numRows);
+}
+
+bool FloodPlaneSave(const char* path, const uint64* rows, int width, int height, bool compress)
+{
+    if (width <= 0 || height <= 0) return false;
+    
+    int rowWords = RowWords(width);
+    if (!compress)
+    {
+        FloodPlaneFile plane;
+        FloodPlaneView view;
+        if (!FloodPlaneCreate(&plane, path, width, height)) return false;
+        
+        uint64* fileRows = FloodPlaneMapRows(&plane, 0, height, &view);
+        if (fileRows)
+        {
+            memcpy(fileRows, rows, (size_t)height*rowWords*sizeof(uint64));
+            FloodPlaneUnmap(&view);
+        }
+        FloodPlaneClose(&plane);
+        return fileRows != 0;
+    }
+    
+    FILE* fh = fopen(path, "wb");
+    if (!fh) return false;
+    
+    uint8 headerBytes[(sizeof(FloodPlaneHeader) + 63) & ~63] = { 0 };
+    FloodPlaneHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Magic = FLOOD_PLANE_MAGIC;
+    header.Version = FLOOD_PLANE_VERSION_COMPRESSED;
+    header.Width = (uint64)width;
+    header.Height = (uint64)height;
+    header.RowStride = (uint64)rowWords*sizeof(uint64);
+    header.DataOffset = sizeof(headerBytes);
+    memcpy(headerBytes, &header, sizeof(header));
+    bool written = fwrite(headerBytes, sizeof(headerBytes), 1, fh) == 1;
+    
+    // Rows are encoded a buffer at a time, so saving needs no copy of the whole plane
+    size_t capacity = Max((size_t)1 << 16, 1 + (size_t)rowWords*sizeof(uint64));
+    uint8* buffer = malloc(capacity);
+    written &= buffer != 0;
+    uint64 lastMask = ~0llu >> (63 - (width - 1)%64);
+    int (*encodeFn)(const uint64*, int, uint64, int, uint8*, size_t, size_t*) =
+        FloodActiveTier() >= FloodTier_BMI2 ? EncodePlaneRows_BMI2 : EncodePlaneRowsBaseline;
+    for (int y = 0; y < height && written; )
+    {
+        size_t size;
+        y += encodeFn(rows + (size_t)y*rowWords, rowWords, lastMask, height - y, buffer, capacity, &size);
+        written = fwrite(buffer, size, 1, fh) == 1;
+    }
+    free(buffer);
+    
+    written &= fclose(fh) == 0;
+    return written;
+}
+
+uint64* FloodPlaneLoad(const char* path, int* width, int* height)
+{
+    FloodPlaneFile plane;
+    FloodPlaneView view;
+    if (FloodPlaneOpen(&plane, path, false))
+    {
+        // Raw rows may be strided wider than the rows they hold
+        const FloodPlaneHeader* header = &plane.Header;
+        int rowWords = RowWords((int)header->Width);
+        uint64 lastMask = ~0llu >> (63 - (header->Width - 1)%64);
+        uint64* rows = malloc(header->Height*rowWords*sizeof(uint64));
+        const uint8* fileRows = rows ? (const uint8*)FloodPlaneMapRows(&plane, 0, (int)header->Height, &view) : 0;
+        if (!fileRows)
+        {
+            free(rows);
+            FloodPlaneClose(&plane);
+            return 0;
+        }
+        AdvisePlaneView(&view);
+        for (uint64 y = 0; y < header->Height; ++y)
+        {
+            memcpy(rows + y*rowWords, fileRows + y*header->RowStride, rowWords*sizeof(uint64));
+            rows[y*rowWords + rowWords-1] &= lastMask;
+        }
+        *width = (int)header->Width;
+        *height = (int)header->Height;
+        FloodPlaneUnmap(&view);
+        FloodPlaneClose(&plane);
+        return rows;
+    }
+    
+    uint64 fileSize;
+    if (!OpenPlaneMapping(&plane, path, false, 0, &fileSize)) return 0;
+    
+    const uint8* bytes = fileSize >= sizeof(FloodPlaneHeader) && (size_t)fileSize == fileSize ? MapPlaneBytes(&plane, 0, (size_t)fileSize, &view) : 0;
+    if (!bytes)
+    {
+        FloodPlaneClose(&plane);
+        return 0;
+    }
+    FloodPlaneHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    
+    uint64* rows = 0;
+    bool valid = header.Magic == FLOOD_PLANE_MAGIC && header.Version == FLOOD_PLANE_VERSION_COMPRESSED &&
+        header.Width >= 1 && header.Width <= INT_MAX && header.Height >= 1 && header.Height <= INT_MAX &&
+        header.RowStride == (uint64)RowWords((int)header.Width)*sizeof(uint64) &&
+        header.DataOffset >= sizeof(header) && header.DataOffset <= fileSize &&
+        // Every row takes at least a tag byte, so a header can't claim more rows than bytes follow it
+        header.Height <= fileSize - header.DataOffset &&
+        (size_t)(header.Height*header.RowStride) == header.Height*header.RowStride;
+    if (valid)
+    {
+        int rowWords = RowWords((int)header.Width);
+        uint64 lastMask = ~0llu >> (63 - (header.Width - 1)%64);
+        bool (*decodeFn)(const uint8*, const uint8*, uint64*, int, uint64, uint64, int) =
+            FloodActiveTier() >= FloodTier_BMI2 ? DecodePlaneRows_BMI2 : DecodePlaneRowsBaseline;
+        
+        AdvisePlaneView(&view);
+        rows = malloc((size_t)(header.Height*header.RowStride));
+        if (rows && !decodeFn(bytes + header.DataOffset, bytes + fileSize, rows, rowWords, header.Width, lastMask, (int)header.Height))
+        {
+            free(rows);
+            rows = 0;
+        }
+        *width = (int)header.Width;
+        *height = (int)header.Height;
+    }
+    
+    UnmapPlaneBytes(&view);
+    FloodPlaneClose(&plane);
+    return rows;
+}
+
+
+// Streamed fill
+//
+// The plane is cut into bands of rows sized to the residency budget, and each band is mapped, filled
+// with the Flood_4 row stack and unmapped again in turn, so only one band of the plane and of the fill
+// is ever mapped. A band is mapped with one row either side, which bitfills may reach but which are
+// never scanned. Rows that gain cells without being completed, the seed row and those halo rows, are
+// marked pending in a bitmap of the whole plane, one bit per row. Sweeps run down the bands and back
+// up, filling every band holding a pending row from those rows, until a sweep finds nothing pending.
+// A region that winds between bands needs a sweep per turn, but most regions settle in a sweep or
+// two, each band read in order, and bands with nothing pending are never mapped at all.
+
+static FORCE_INLINE int64 StreamBandRows(const uint64* bitRows, uint64* fillRows, int rowWords, int numRows, int lo, int hi, int first, uint64* pending, int* stack, uint64* stackedRows, uint64 diagonals)
+{
+    // Window rows are plane rows from 'first', lo..hi being the band and the rest halo rows
+    int stackCount = 0;
+    for (int r = lo; r <= hi; ++r)
+    {
+        int row = first + r;
+        if (pending[row/64] & (1llu << (row%64)))
+        {
+            pending[row/64] &= ~(1llu << (row%64));
+            stackedRows[r/64] |= 1llu << (r%64);
+            stack[stackCount++] = r;
+        }
+    }
+    
+    int64 numFilled = 0;
+    while (stackCount)
+    {
+        int rowIndex = stack[--stackCount];
+        stackedRows[rowIndex/64] &= ~(1llu << (rowIndex%64));
+        
+        uint64* fillRow = fillRows + (size_t)rowIndex*rowWords;
+        numFilled += SimulScanRow(bitRows + (size_t)rowIndex*rowWords, 0, fillRow, rowWords);
+        
+        for (int rowNext = rowIndex-1; rowNext <= rowIndex+1; rowNext += 2)
+        {
+            // Bitfill up, then down
+            if ((rowNext < 0) | (rowNext >= numRows)) continue;
+            
+            int rowFilled = SimulFillRow(fillRow, bitRows + (size_t)rowNext*rowWords, 0, fillRows + (size_t)rowNext*rowWords, rowWords, diagonals, 0, rowNext);
+            numFilled += rowFilled;
+            if (!rowFilled) continue;
+            
+            if ((rowNext < lo) | (rowNext > hi))
+            {
+                pending[(first + rowNext)/64] |= 1llu << ((first + rowNext)%64);
+            }
+            else if (!(stackedRows[rowNext/64] & (1llu << (rowNext%64))))
+            {
+                stackedRows[rowNext/64] |= 1llu << (rowNext%64);
+                stack[stackCount++] = rowNext;
+            }
+        }
+    }
+    
+    return numFilled;
+}
+
+static int64 StreamBandRowsBaseline(const uint64* bitRows, uint64* fillRows, int rowWords, int numRows, int lo, int hi, int first, uint64* pending, int* stack, uint64* stackedRows, uint64 diagonals)
+{
+    return StreamBandRows(bitRows, fillRows, rowWords, numRows, lo, hi, first, pending, stack, stackedRows, diagonals);
+}
+
+TARGET_BMI2 static int64 StreamBandRows_BMI2(const uint64* bitRows, uint64* fillRows, int rowWords, int numRows, int lo, int hi, int first, uint64* pending, int* stack, uint64* stackedRows, uint64 diagonals)
+{
+    return StreamBandRows(bitRows, fillRows, rowWords, numRows, lo, hi, first, pending, stack, stackedRows, diagonals);
+}
+
+static bool RowsPending(const uint64* pending, int lo, int hi)
+{
+    for (int w = lo/64; w <= hi/64; ++w)
+    {
+        uint64 mask = ~0llu;
+        if (w == lo/64) mask &= ~0llu << (lo%64);
+        if (w == hi/64) mask &= ~0llu >> (63 - hi%64);
+        if (pending[w] & mask) return true;
+    }
+    return false;
+}
+
+int64 Flood_Streamed(FloodContext* ctx, FloodPlaneFile* bits, FloodPlaneFile* filled, int seedX, int seedY, size_t maxResidentBytes)
+{
+    const FloodPlaneHeader* header = &bits->Header;
+    if (!filled->Writable || filled->Header.Width != header->Width || filled->Header.Height != header->Height ||
+        filled->Header.RowStride != header->RowStride) return -1;
+    
+    int width = (int)header->Width;
+    int height = (int)header->Height;
+    if ((seedX < 0) | (seedX >= width) | (seedY < 0) | (seedY >= height)) return 0;
+    
+    // Two mapped windows of the band plus its halo rows
+    int rowWords = (int)(header->RowStride/sizeof(uint64));
+    uint64 budgetRows = maxResidentBytes/(2*header->RowStride);
+    int bandRows = budgetRows > (uint64)height + 2 ? height : budgetRows > 3 ? (int)budgetRows - 2 : 1;
+    int numBands = (height + bandRows - 1)/bandRows;
+    int planeFlagWords = (height + 63)/64;
+    int bandFlagWords = (bandRows + 2 + 63)/64;
+    
+    uint64* pending = FloodContextRowFlags(ctx, planeFlagWords + bandFlagWords);
+    uint64* stackedRows = pending + planeFlagWords;
+    memset(pending, 0, sizeof(uint64)*(planeFlagWords + bandFlagWords));
+    int* stack = FloodContextStack(ctx, bandRows + 2);
+    uint64 diagonals = FloodDiagonals(ctx);
+    int64 (*bandFn)(const uint64*, uint64*, int, int, int, int, int, uint64*, int*, uint64*, uint64) =
+        FloodActiveTier() >= FloodTier_BMI2 ? StreamBandRows_BMI2 : StreamBandRowsBaseline;
+    
+    // Seed cell
+    FloodPlaneView bitView;
+    FloodPlaneView fillView;
+    const uint64* bitRow = FloodPlaneMapRows(bits, seedY, 1, &bitView);
+    uint64* fillRow = bitRow ? FloodPlaneMapRows(filled, seedY, 1, &fillView) : 0;
+    if (!fillRow)
+    {
+        if (bitRow) FloodPlaneUnmap(&bitView);
+        return -1;
+    }
+    uint64 seedBit = 1llu << (seedX%64);
+    bool seeded = (bitRow[seedX/64] & seedBit) && !(fillRow[seedX/64] & seedBit);
+    if (seeded) fillRow[seedX/64] |= seedBit;
+    FloodPlaneUnmap(&fillView);
+    FloodPlaneUnmap(&bitView);
+    if (!seeded) return 0;
+    
+    pending[seedY/64] |= 1llu << (seedY%64);
+    int64 numFilled = 1;
+    
+    bool swept = true;
+    for (int direction = 1; swept; direction = -direction)
+    {
+        swept = false;
+        for (int b = direction > 0 ? 0 : numBands-1; (b >= 0) & (b < numBands); b += direction)
+        {
+            int lo = b*bandRows;
+            int hi = lo + bandRows < height ? lo + bandRows - 1 : height - 1;
+            if (!RowsPending(pending, lo, hi)) continue;
+            
+            int first = lo > 0 ? lo - 1 : lo;
+            int last = hi < height - 1 ? hi + 1 : hi;
+            const uint64* bitRows = FloodPlaneMapRows(bits, first, last - first + 1, &bitView);
+            uint64* fillRows = bitRows ? FloodPlaneMapRows(filled, first, last - first + 1, &fillView) : 0;
+            if (!fillRows)
+            {
+                if (bitRows) FloodPlaneUnmap(&bitView);
+                return -1;
+            }
+            AdvisePlaneView(&bitView);
+            AdvisePlaneView(&fillView);
+            
+            numFilled += bandFn(bitRows, fillRows, rowWords, last - first + 1, lo - first, hi - first, first, pending, stack, stackedRows, diagonals);
+            swept = true;
+            
+            FloodPlaneUnmap(&fillView);
+            FloodPlaneUnmap(&bitView);
+        }
+    }
+    
+    return numFilled;
+}
+
+
+// Bit-sliced fill
+//
+// Word c of a sliced plane holds cell c of 64 decks, bit d for deck d, so every deck of the group grows
+// its fill in the same word ops and nothing branches on the cells. Slicing a group is one 64x64 bit
+// transpose per row: word y of each deck goes in, the cells x of row y come out, and the fill goes back
+// the same way. A sliced row is 64 separate words that shifts can't reach along, so rather than dilating
+// the whole plane a cell per step, the fill sweeps it in place, down the rows and back up. Each row takes
+// what its neighbouring rows reach and then completes its spans left to right and right to left, so one
+// sweep carries a fill any distance along its direction, a region needs one sweep per turn back against
+// it, and a sweep that changes nothing is the fixpoint of every deck of the group at once. Sliced rows
+// are padded with an empty cell either end and an empty row above and below, so no cell is an edge case.
+
+#define SLICED_STRIDE (64 + 2)
+#define SLICED_PLANE_WORDS (SLICED_STRIDE*SLICED_STRIDE)
+
+// Swaps the high j bits of each word k with the low j bits of word k + j, for every k with bit j clear
+static FORCE_INLINE void TransposeStage(uint64* m, int j, uint64 mask)
+{
+    for (int k0 = 0; k0 < 64; k0 += 2*j)
+    {
+        for (int k = k0; k < k0 + j; ++k)
+        {
+            uint64 t = ((m[k] >> j) ^ m[k + j]) & mask;
+            m[k] ^= t << j;
+            m[k + j] ^= t;
+        }
+    }
+}
+
+// 64x64 bit transpose in place, bit x of word y becomes bit y of word x. Stages are spelled out so each
+// one's loops have fixed bounds, which lets the compiler unroll them and vectorize the wide ones.
+static FORCE_INLINE void TransposeBits64(uint64* m)
+{
+    TransposeStage(m, 32, 0x00000000ffffffffllu);
+    TransposeStage(m, 16, 0x0000ffff0000ffffllu);
+    TransposeStage(m, 8, 0x00ff00ff00ff00ffllu);
+    TransposeStage(m, 4, 0x0f0f0f0f0f0f0f0fllu);
+    TransposeStage(m, 2, 0x3333333333333333llu);
+    TransposeStage(m, 1, 0x5555555555555555llu);
+}
+
+// Slices a group of up to 64 decks per lane into the open cells, and sets their seeds in the fill. A
+// deck's open cells are the ones not already filled, as in Flood_3.
+static FORCE_INLINE void SliceGroup(const uint8* bitdecks, const uint8* filled, const FloodSeed* seeds, int numDecks, int lanes, uint64* open, uint64* fill)
+{
+    uint64 m[64];
+    for (int lane = 0; lane*64 < numDecks; ++lane)
+    {
+        int first = lane*64;
+        int laneDecks = numDecks - first < 64 ? numDecks - first : 64;
+        for (int y = 0; y < 64; ++y)
+        {
+            for (int d = 0; d < 64; ++d)
+            {
+                const uint64* bitRows = (const uint64*)(bitdecks + (first + d)*decksize);
+                const uint64* fillRows = (const uint64*)(filled + (first + d)*decksize);
+                m[d] = d < laneDecks ? bitRows[y] & ~fillRows[y] : 0;
+            }
+            TransposeBits64(m);
+            
+            uint64* openRow = open + ((size_t)(y + 1)*SLICED_STRIDE + 1)*lanes + lane;
+            for (int x = 0; x < 64; ++x) openRow[(size_t)x*lanes] = m[x];
+        }
+        
+        for (int d = 0; d < laneDecks; ++d)
+        {
+            const FloodSeed* seed = &seeds[first + d];
+            if ((seed->X < 0) | (seed->X >= 64) | (seed->Y < 0) | (seed->Y >= 64)) continue;
+            
+            size_t cell = ((size_t)(seed->Y + 1)*SLICED_STRIDE + seed->X + 1)*lanes + lane;
+            fill[cell] |= open[cell] & (1llu << d);
+        }
+    }
+}
+
+// Adds the fill of every lane to its decks' 'filled'. Returns the number of newly filled cells.
+static FORCE_INLINE int64 UnsliceGroup(const uint64* fill, uint8* filled, int numDecks, int lanes)
+{
+    uint64 m[64];
+    int64 numFilled = 0;
+    for (int lane = 0; lane*64 < numDecks; ++lane)
+    {
+        int first = lane*64;
+        int laneDecks = numDecks - first < 64 ? numDecks - first : 64;
+        for (int y = 0; y < 64; ++y)
+        {
+            const uint64* fillRow = fill + ((size_t)(y + 1)*SLICED_STRIDE + 1)*lanes + lane;
+            for (int x = 0; x < 64; ++x) m[x] = fillRow[(size_t)x*lanes];
+            TransposeBits64(m);
+            
+            for (int d = 0; d < laneDecks; ++d)
+            {
+                ((uint64*)(filled + (first + d)*decksize))[y] |= m[d];
+                numFilled += CountBits(m[d]);
+            }
+        }
+    }
+    return numFilled;
+}
+
+static void SliceGroupBaseline(const uint8* bitdecks, const uint8* filled, const FloodSeed* seeds, int numDecks, int lanes, uint64* open, uint64* fill)
+{
+    SliceGroup(bitdecks, filled, seeds, numDecks, lanes, open, fill);
+}
+
+TARGET_AVX2 static void SliceGroup_AVX2(const uint8* bitdecks, const uint8* filled, const FloodSeed* seeds, int numDecks, int lanes, uint64* open, uint64* fill)
+{
+    SliceGroup(bitdecks, filled, seeds, numDecks, lanes, open, fill);
+}
+
+static int64 UnsliceGroupBaseline(const uint64* fill, uint8* filled, int numDecks, int lanes)
+{
+    return UnsliceGroup(fill, filled, numDecks, lanes);
+}
+
+TARGET_AVX2 static int64 UnsliceGroup_AVX2(const uint64* fill, uint8* filled, int numDecks, int lanes)
+{
+    return UnsliceGroup(fill, filled, numDecks, lanes);
+}
+
+// One sweep of a group of 64 decks over the rows from 'first' in steps of 'step'. Returns true when it
+// filled anything.
+static bool SweepSliced64(uint64* fill, const uint64* open, int first, int step, uint64 diagonals)
+{
+    uint64 changed = 0;
+    for (int y = first; (y >= 0) & (y < 64); y += step)
+    {
+        uint64* row = fill + (size_t)(y + 1)*SLICED_STRIDE + 1;
+        const uint64* up = row - SLICED_STRIDE;
+        const uint64* down = row + SLICED_STRIDE;
+        const uint64* openRow = open + (size_t)(y + 1)*SLICED_STRIDE + 1;
+        
+        // The rows either side are or'd a cell ahead, and only the run carried along the row is serial
+        uint64 sideLeft = 0;
+        uint64 side = up[0] | down[0];
+        uint64 left = 0;
+        for (int x = 0; x < 64; ++x)
+        {
+            uint64 sideRight = up[x+1] | down[x+1];
+            uint64 reach = side | ((sideLeft | sideRight) & diagonals);
+            uint64 cell = row[x] | (reach & openRow[x]);
+            left = cell | (left & openRow[x]);
+            changed |= left ^ row[x];
+            row[x] = left;
+            sideLeft = side;
+            side = sideRight;
+        }
+        
+        uint64 right = 0;
+        for (int x = 63; x >= 0; --x)
+        {
+            right = row[x] | (right & openRow[x]);
+            changed |= right ^ row[x];
+            row[x] = right;
+        }
+    }
+    return changed != 0;
+}
+
+// SweepSliced64 over groups of 256 decks, four words to a cell
+TARGET_AVX2 static bool SweepSliced256(uint64* fill, const uint64* open, int first, int step, uint64 diagonals)
+{
+    __m256i diagonalLanes = _mm256_set1_epi64x((long long)diagonals);
+    __m256i changed = _mm256_setzero_si256();
+    for (int y = first; (y >= 0) & (y < 64); y += step)
+    {
+        __m256i* row = (__m256i*)fill + (size_t)(y + 1)*SLICED_STRIDE + 1;
+        const __m256i* up = row - SLICED_STRIDE;
+        const __m256i* down = row + SLICED_STRIDE;
+        const __m256i* openRow = (const __m256i*)open + (size_t)(y + 1)*SLICED_STRIDE + 1;
+        
+        __m256i sideLeft = _mm256_setzero_si256();
+        __m256i side = _mm256_or_si256(_mm256_loadu_si256(&up[0]), _mm256_loadu_si256(&down[0]));
+        __m256i left = _mm256_setzero_si256();
+        for (int x = 0; x < 64; ++x)
+        {
+            __m256i sideRight = _mm256_or_si256(_mm256_loadu_si256(&up[x+1]), _mm256_loadu_si256(&down[x+1]));
+            __m256i reach = _mm256_or_si256(side, _mm256_and_si256(_mm256_or_si256(sideLeft, sideRight), diagonalLanes));
+            __m256i open = _mm256_loadu_si256(&openRow[x]);
+            __m256i old = _mm256_loadu_si256(&row[x]);
+            __m256i cell = _mm256_or_si256(old, _mm256_and_si256(reach, open));
+            left = _mm256_or_si256(cell, _mm256_and_si256(left, open));
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(left, old));
+            _mm256_storeu_si256(&row[x], left);
+            sideLeft = side;
+            side = sideRight;
+        }
+        
+        __m256i right = _mm256_setzero_si256();
+        for (int x = 63; x >= 0; --x)
+        {
+            __m256i old = _mm256_loadu_si256(&row[x]);
+            right = _mm256_or_si256(old, _mm256_and_si256(right, _mm256_loadu_si256(&openRow[x])));
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(right, old));
+            _mm256_storeu_si256(&row[x], right);
+        }
+    }
+    return !_mm256_testz_si256(changed, changed);
+}
+
+// SweepSliced64 over groups of 512 decks, eight words to a cell
+TARGET_AVX512 static bool SweepSliced512(uint64* fill, const uint64* open, int first, int step, uint64 diagonals)
+{
+    __m512i diagonalLanes = _mm512_set1_epi64((long long)diagonals);
+    __m512i changed = _mm512_setzero_si512();
+    for (int y = first; (y >= 0) & (y < 64); y += step)
+    {
+        __m512i* row = (__m512i*)fill + (size_t)(y + 1)*SLICED_STRIDE + 1;
+        const __m512i* up = row - SLICED_STRIDE;
+        const __m512i* down = row + SLICED_STRIDE;
+        const __m512i* openRow = (const __m512i*)open + (size_t)(y + 1)*SLICED_STRIDE + 1;
+        
+        __m512i sideLeft = _mm512_setzero_si512();
+        __m512i side = _mm512_or_si512(_mm512_loadu_si512(&up[0]), _mm512_loadu_si512(&down[0]));
+        __m512i left = _mm512_setzero_si512();
+        for (int x = 0; x < 64; ++x)
+        {
+            __m512i sideRight = _mm512_or_si512(_mm512_loadu_si512(&up[x+1]), _mm512_loadu_si512(&down[x+1]));
+            __m512i reach = _mm512_ternarylogic_epi64(side, _mm512_or_si512(sideLeft, sideRight), diagonalLanes, TERN_A_OR_B_AND_C);
+            __m512i open = _mm512_loadu_si512(&openRow[x]);
+            __m512i old = _mm512_loadu_si512(&row[x]);
+            __m512i cell = _mm512_ternarylogic_epi64(old, reach, open, TERN_A_OR_B_AND_C);
+            left = _mm512_ternarylogic_epi64(cell, left, open, TERN_A_OR_B_AND_C);
+            changed = _mm512_or_si512(changed, _mm512_xor_si512(left, old));
+            _mm512_storeu_si512(&row[x], left);
+            sideLeft = side;
+            side = sideRight;
+        }
+        
+        __m512i right = _mm512_setzero_si512();
+        for (int x = 63; x >= 0; --x)
+        {
+            __m512i old = _mm512_loadu_si512(&row[x]);
+            right = _mm512_ternarylogic_epi64(old, right, _mm512_loadu_si512(&openRow[x]), TERN_A_OR_B_AND_C);
+            changed = _mm512_or_si512(changed, _mm512_xor_si512(right, old));
+            _mm512_storeu_si512(&row[x], right);
+        }
+    }
+    return _mm512_test_epi64_mask(changed, changed) != 0;
+}
+
+int64 Flood_Sliced(FloodContext* ctx, const uint8* bitdecks, uint8* filled, const FloodSeed* seeds, int numDecks)
+{
+    FloodTier tier = FloodActiveTier();
+    int maxLanes = tier >= FloodTier_AVX512 ? 8 : tier >= FloodTier_AVX2 ? 4 : 1;
+    uint64* open = FloodContextRows(ctx, 2*(size_t)SLICED_PLANE_WORDS*maxLanes);
+    uint64 diagonals = FloodDiagonals(ctx);
+    void (*sliceFn)(const uint8*, const uint8*, const FloodSeed*, int, int, uint64*, uint64*) =
+        maxLanes > 1 ? SliceGroup_AVX2 : SliceGroupBaseline;
+    int64 (*unsliceFn)(const uint64*, uint8*, int, int) = maxLanes > 1 ? UnsliceGroup_AVX2 : UnsliceGroupBaseline;
+    int64 numFilled = 0;
+    
+    for (int first = 0; first < numDecks; first += 64*maxLanes)
+    {
+        // A short last group doesn't pay for lanes it has no decks for
+        int groupDecks = numDecks - first < 64*maxLanes ? numDecks - first : 64*maxLanes;
+        int lanes = groupDecks > 256 ? 8 : groupDecks > 64 ? 4 : 1;
+        bool (*sweepFn)(uint64*, const uint64*, int, int, uint64) =
+            lanes == 8 ? SweepSliced512 : lanes == 4 ? SweepSliced256 : SweepSliced64;
+        
+        uint64* fill = open + (size_t)SLICED_PLANE_WORDS*lanes;
+        memset(open, 0, sizeof(uint64)*2*SLICED_PLANE_WORDS*lanes);
+        sliceFn(bitdecks + first*decksize, filled + first*decksize, seeds + first, groupDecks, lanes, open, fill);
+        
+        int step = 1;
+        while (sweepFn(fill, open, step > 0 ? 0 : 63, step, diagonals)) step = -step;
+        
+        numFilled += unsliceFn(fill, filled + first*decksize, groupDecks, lanes);
+    }
+    
+    return numFilled;
+}
+
+
+// Distance fill
+//
+// Breadth first a word at a time. The frontier of a step is a list of the words holding the cells first
+// reached that step, along with those cells, so a step costs a few word ops per frontier word however
+// large the plane is, where a scalar BFS pays a queue push, a pop and a test per neighbour for every cell.
+// Each frontier word spreads its cells one step into the words it can reach, sideways within the word and
+// across into the words either side, straight (or with 8-connectivity diagonally) into the rows either
+// side, and ORs them into a plane of reached bits. A reached word goes on a list the first time it gets
+// bits, with no branch, and walking that list keeps the bits & ~filled of each as the next frontier.
+//
+// When the frontier has as many words as the rows it spans, the step instead dilates those rows whole:
+// the frontier words are laid into the reached plane, each row word takes the shifted words of its own
+// row and the rows either side, and keeps what is in bits & ~filled. The reached plane lives in the
+// context and is cleared through the lists as the step ends, and decks whose width is a multiple of 64
+// are worked in place, so a fill touches only the words its frontiers pass through.
+
+// ORs bits into a word of the reached plane, listing the word if these are its first
+static FORCE_INLINE int ReachWord(uint64* reached, int* touched, int numTouched, int word, uint64 bits)
+{
+    touched[numTouched] = word;
+    numTouched += (reached[word] == 0) & (bits != 0);
+    reached[word] |= bits;
+    return numTouched;
+}
+
+// A word shifted a cell either way, with the cells carried in from the words either side of it
+static FORCE_INLINE uint64 SidewaysWord(uint64 left, uint64 word, uint64 right)
+{
+    return word << 1 | word >> 1 | left >> 63 | right << 63;
+}
+
+// Works on rows of whole words. 'lists' holds 2*(rowWords*dim + 1) words of scratch for the frontier bits.
+static FORCE_INLINE int GrowWavefrontRows(FloodContext* ctx, const uint64* bitRows, uint64* fillRows, uint64* lists, int dim, int seedX, int seedY, uint16* distances, uint8* fronts, int maxFronts)
+{
+    int rowWords = RowWords(dim);
+    size_t numWords = (size_t)rowWords*dim;
+    size_t deckBytes = ((size_t)dim*dim + 7)/8;
+    int seedWord = seedY*rowWords + seedX/64;
+    uint64 seedBit = 1llu << (seedX%64);
+    if (!(bitRows[seedWord] & seedBit) || (fillRows[seedWord] & seedBit)) return 0;
+    
+    uint64* reached = FloodContextReached(ctx, numWords);
+    // A slot spare in each list, ReachWord writes one past the words it has listed
+    int* frontWords = FloodContextStack(ctx, 2*numWords + 2);
+    int* nextWords = frontWords + numWords + 1;
+    uint64* frontBits = lists;
+    uint64* nextBits = lists + numWords + 1;
+    uint64 diagonals = FloodDiagonals(ctx);
+    
+    fillRows[seedWord] |= seedBit;
+    frontWords[0] = seedWord;
+    frontBits[0] = seedBit;
+    int frontCount = 1;
+    int numFronts = 0;
+    
+    while (frontCount)
+    {
+        uint16 distance = numFronts < FLOOD_DISTANCE_UNREACHED ? (uint16)numFronts : FLOOD_DISTANCE_UNREACHED - 1;
+        uint8* frontDeck = fronts ? fronts + (size_t)numFronts*deckBytes : 0;
+        bool lastFront = fronts && numFronts + 1 == maxFronts;
+        if (frontDeck) memset(frontDeck, 0, deckBytes);
+        
+        int yLow = dim;
+        int yHigh = -1;
+        for (int i = 0; i < frontCount; ++i)
+        {
+            int word = frontWords[i];
+            int y = word/rowWords;
+            int w = word - y*rowWords;
+            uint64 bits = frontBits[i];
+            yLow = y < yLow ? y : yLow;
+            yHigh = y > yHigh ? y : yHigh;
+            if (frontDeck && dim%64 == 0) ((uint64*)frontDeck)[word] = bits;
+            else if (frontDeck) StoreBits(frontDeck, (size_t)y*dim + w*64, dim - w*64 < 64 ? dim - w*64 : 64, bits);
+            if (distances)
+            {
+                uint16* distanceRow = distances + (size_t)y*dim + w*64;
+                for (uint64 b = bits; b; b &= b - 1) distanceRow[LowestBit(b)] = distance;
+            }
+        }
+        if (++numFronts, lastFront) break;
+        
+        // Dense when the frontier has as many words as the rows it spans
+        int nextCount = 0;
+        if ((size_t)(yHigh - yLow + 1)*rowWords <= (size_t)frontCount)
+        {
+            // Dilate every word of the rows the frontier spans, and the rows either side. The reached
+            // plane is clear outside the frontier, so only the plane's edges need a check.
+            for (int i = 0; i < frontCount; ++i) reached[frontWords[i]] = frontBits[i];
+            int yFirst = yLow > 0 ? yLow - 1 : 0;
+            int yLast = yHigh < dim-1 ? yHigh + 1 : dim-1;
+            for (int y = yFirst; y <= yLast; ++y)
+            {
+                const uint64* row = reached + (size_t)y*rowWords;
+                const uint64* above = y > 0 ? row - rowWords : 0;
+                const uint64* below = y < dim-1 ? row + rowWords : 0;
+                
+                // Each row word and the words straight above and below it, with the next word of each
+                // along loaded one step ahead
+                uint64 sidePrev = 0;
+                uint64 acrossPrev = 0;
+                uint64 sideWord = row[0];
+                uint64 acrossWord = (above ? above[0] : 0) | (below ? below[0] : 0);
+                for (int w = 0; w < rowWords; ++w)
+                {
+                    bool more = w < rowWords-1;
+                    uint64 sideNext = more ? row[w+1] : 0;
+                    uint64 acrossNext = more ? (above ? above[w+1] : 0) | (below ? below[w+1] : 0) : 0;
+                    uint64 reach = SidewaysWord(sidePrev, sideWord, sideNext) | acrossWord | (SidewaysWord(acrossPrev, acrossWord, acrossNext) & diagonals);
+                    sidePrev = sideWord;
+                    sideWord = sideNext;
+                    acrossPrev = acrossWord;
+                    acrossWord = acrossNext;
+                    
+                    int word = y*rowWords + w;
+                    uint64 bits = reach & bitRows[word] & ~fillRows[word];
+                    fillRows[word] |= bits;
+                    nextWords[nextCount] = word;
+                    nextBits[nextCount] = bits;
+                    nextCount += bits != 0;
+                }
+            }
+            for (int i = 0; i < frontCount; ++i) reached[frontWords[i]] = 0;
+        }
+        else
+        {
+            int numTouched = 0;
+            for (int i = 0; i < frontCount; ++i)
+            {
+                int word = frontWords[i];
+                int y = word/rowWords;
+                int w = word - y*rowWords;
+                uint64 bits = frontBits[i];
+                
+                // Cells carried over a word edge, into the words either side in this row and with
+                // 8-connectivity in the rows either side too. Most words have none to carry.
+                uint64 carryLeft = bits << 63;
+                uint64 carryRight = bits >> 63;
+                uint64 across = bits | ((bits << 1 | bits >> 1) & diagonals);
+                numTouched = ReachWord(reached, nextWords, numTouched, word, bits << 1 | bits >> 1);
+                if (y > 0) numTouched = ReachWord(reached, nextWords, numTouched, word - rowWords, across);
+                if (y < dim-1) numTouched = ReachWord(reached, nextWords, numTouched, word + rowWords, across);
+                if (carryLeft && w > 0)
+                {
+                    numTouched = ReachWord(reached, nextWords, numTouched, word-1, carryLeft);
+                    if (diagonals && y > 0) numTouched = ReachWord(reached, nextWords, numTouched, word - rowWords - 1, carryLeft);
+                    if (diagonals && y < dim-1) numTouched = ReachWord(reached, nextWords, numTouched, word + rowWords - 1, carryLeft);
+                }
+                if (carryRight && w < rowWords-1)
+                {
+                    numTouched = ReachWord(reached, nextWords, numTouched, word+1, carryRight);
+                    if (diagonals && y > 0) numTouched = ReachWord(reached, nextWords, numTouched, word - rowWords + 1, carryRight);
+                    if (diagonals && y < dim-1) numTouched = ReachWord(reached, nextWords, numTouched, word + rowWords + 1, carryRight);
+                }
+            }
+            
+            // Keep the reached cells still open, packing the frontier list down in place
+            for (int i = 0; i < numTouched; ++i)
+            {
+                int word = nextWords[i];
+                uint64 bits = reached[word] & bitRows[word] & ~fillRows[word];
+                reached[word] = 0;
+                fillRows[word] |= bits;
+                nextWords[nextCount] = word;
+                nextBits[nextCount] = bits;
+                nextCount += bits != 0;
+            }
+        }
+        
+        int* words = frontWords;
+        frontWords = nextWords;
+        nextWords = words;
+        uint64* frontier = frontBits;
+        frontBits = nextBits;
+        nextBits = frontier;
+        frontCount = nextCount;
+    }
+    
+    return numFronts;
+}
+
+// Writes each front's distance into 'distances' and its cells into 'fronts', either may be null, and
+// stops after maxFronts fronts when there are fronts to write. Returns the number of fronts.
+static FORCE_INLINE int GrowWavefronts(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint16* distances, uint8* fronts, int maxFronts)
+{
+    // Every cell starts out as FLOOD_DISTANCE_UNREACHED, all ones
+    if (distances) memset(distances, 0xff, sizeof(uint16)*dim*dim);
+    if ((seedX < 0) | (seedX >= dim) | (seedY < 0) | (seedY >= dim)) return 0;
+    
+    size_t numWords = (size_t)RowWords(dim)*dim;
+    size_t listWords = 2*(numWords + 1);
+    if (dim % 64 == 0)
+    {
+        uint64* lists = FloodContextRows(ctx, listWords);
+        return GrowWavefrontRows(ctx, (const uint64*)bitdeck, (uint64*)filled, lists, dim, seedX, seedY, distances, fronts, maxFronts);
+    }
+    
+    uint64* lists = FloodContextRows(ctx, listWords + 2*numWords);
+    uint64* bitRows = lists + listWords;
+    uint64* fillRows = bitRows + numWords;
+    PadRows(bitdeck, dim, bitRows);
+    PadRows(filled, dim, fillRows);
+    int numFronts = GrowWavefrontRows(ctx, bitRows, fillRows, lists, dim, seedX, seedY, distances, fronts, maxFronts);
+    if (numFronts) UnpadRows(fillRows, dim, filled);
+    return numFronts;
+}
+
+static int GrowWavefrontsBaseline(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint16* distances, uint8* fronts, int maxFronts)
+{
+    return GrowWavefronts(ctx, bitdeck, dim, filled, seedX, seedY, distances, fronts, maxFronts);
+}
+
+TARGET_BMI2 static int GrowWavefronts_BMI2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint16* distances, uint8* fronts, int maxFronts)
+{
+    return GrowWavefronts(ctx, bitdeck, dim, filled, seedX, seedY, distances, fronts, maxFronts);
+}
+
+int Flood_Distances(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint16* distances)
+{
+    if (FloodActiveTier() >= FloodTier_BMI2) return GrowWavefronts_BMI2(ctx, bitdeck, dim, filled, seedX, seedY, distances, 0, 0);
+    return GrowWavefrontsBaseline(ctx, bitdeck, dim, filled, seedX, seedY, distances, 0, 0);
+}
+
+int Flood_Wavefronts(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* filled, int seedX, int seedY, uint8* fronts, int maxFronts)
+{
+    if (maxFronts <= 0) return 0;
+    if (FloodActiveTier() >= FloodTier_BMI2) return GrowWavefronts_BMI2(ctx, bitdeck, dim, filled, seedX, seedY, 0, fronts, maxFronts);
+    return GrowWavefrontsBaseline(ctx, bitdeck, dim, filled, seedX, seedY, 0, fronts, maxFronts);
+}
+
+
+// Enclosed regions
+//
+// Every open cell on the border seeds the fill at once: the first and last rows whole, and the first and
+// last bit of every row between. Each seeded row goes on the Flood_3 row stack before the first row is
+// popped, so one pass of row scans and bitfills reaches every border-connected cell, however many border
+// regions there are, and the open cells it didn't reach are the enclosed ones.
+
+static FORCE_INLINE int EnclosedFill(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* enclosed)
+{
+    if (dim <= 0) return 0;
+    
+    int rowWords = RowWords(dim);
+    size_t rowsWords = (size_t)rowWords*dim;
+    uint64 lastBit = 1llu << ((dim-1)%64);
+    
+    // When dim is a multiple of 64 the fill is built in 'enclosed' and turned into its open complement
+    // in place, otherwise in padded working rows.
+    const uint64* bitRows = (const uint64*)bitdeck;
+    uint64* fillRows = (uint64*)enclosed;
+    if (dim % 64)
+    {
+        fillRows = FloodContextRows(ctx, 2*rowsWords);
+        PadRows(bitdeck, dim, fillRows + rowsWords);
+        bitRows = fillRows + rowsWords;
+    }
+    memset(fillRows, 0, sizeof(uint64)*rowsWords);
+    
+    int* stack = FloodContextStack(ctx, dim);
+    int stackCount = 0;
+    uint64* stackedRows = FloodContextRowFlags(ctx, rowWords);
+    memset(stackedRows, 0, sizeof(uint64)*rowWords);
+    
+    for (int y = 0; y < dim; ++y)
+    {
+        const uint64* bitRow = bitRows + (size_t)y*rowWords;
+        uint64* fillRow = fillRows + (size_t)y*rowWords;
+        uint64 seeded = 0;
+        if ((y == 0) | (y == dim-1))
+        {
+            for (int w = 0; w < rowWords; ++w)
+            {
+                fillRow[w] = bitRow[w];
+                seeded |= bitRow[w];
+            }
+        }
+        else
+        {
+            fillRow[0] = bitRow[0] & 1;
+            fillRow[rowWords-1] |= bitRow[rowWords-1] & lastBit;
+            seeded = fillRow[0] | fillRow[rowWords-1];
+        }
+        
+        if (seeded)
+        {
+            stack[stackCount++] = y;
+            stackedRows[y/64] |= 1llu << (y%64);
+        }
+    }
+    
+    SimulSpanFillStack(bitRows, 0, fillRows, dim, stack, stackCount, stackedRows, FloodDiagonals(ctx), 0);
+    
+    int numEnclosed = 0;
+    for (size_t i = 0; i < rowsWords; ++i)
+    {
+        fillRows[i] = bitRows[i] & ~fillRows[i];
+        numEnclosed += CountBits(fillRows[i]);
+    }
+    
+    // UnpadRows leaves the spare bits of the last byte alone, and 'enclosed' is output only
+    if (dim % 64)
+    {
+        enclosed[((size_t)dim*dim - 1)/8] = 0;
+        UnpadRows(fillRows, dim, enclosed);
+    }
+    
+    return numEnclosed;
+}
+
+static int EnclosedFillBaseline(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* enclosed)
+{
+    return EnclosedFill(ctx, bitdeck, dim, enclosed);
+}
+
+TARGET_BMI2 static int EnclosedFill_BMI2(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* enclosed)
+{
+    return EnclosedFill(ctx, bitdeck, dim, enclosed);
+}
+
+int Flood_Enclosed(FloodContext* ctx, const uint8* bitdeck, int dim, uint8* enclosed)
+{
+    if (FloodActiveTier() >= FloodTier_BMI2) return EnclosedFill_BMI2(ctx, bitdeck, dim, enclosed);
+    return EnclosedFillBaseline(ctx, bitdeck, dim, enclosed);
+}
+
+
+// Clipped fill
+//
+// The clip plane is ANDed into each row of bits as the row stack loads it, in the row scan and in the
+// bitfills of the rows either side, so a zone never has to be built as a deck of its own. Sizes with a
+// kernel of their own in Flood_Dispatch take the clip in that kernel's loads too. Planes whose rows
+// aren't whole words get a padded copy of the bits anyway, and the clip is folded into the byte loads
+// of that copy.
+
+// LoadBits of bitdeck & clip
+static uint64 LoadClippedBits(const uint8* deck, const uint8* clip, size_t bitIndex, int numBits)
+{
+    uint64 value = 0;
+    int loaded = 0;
+    while (loaded < numBits)
+    {
+        int shift = bitIndex & 7;
+        int count = (8 - shift) < (numBits - loaded) ? (8 - shift) : (numBits - loaded);
+        uint8 bits = deck[bitIndex >> 3] & clip[bitIndex >> 3];
+        value |= (uint64)((bits >> shift) & ((1u << count) - 1)) << loaded;
+        loaded += count;
+        bitIndex += count;
+    }
+    return value;
+}
+
+static FORCE_INLINE int ClippedFill(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY)
+{
+    if (dim == 128) return ClippedSimulSpanFill128(ctx, bitdeck, clip, dim, filled, seedX, seedY, 0);
+    
+    int rowWords = RowWords(dim);
+    size_t rowsWords = (size_t)rowWords*dim;
+    const uint64* bitRows = (const uint64*)bitdeck;
+    const uint64* clipRows = (const uint64*)clip;
+    uint64* fillRows = (uint64*)filled;
+    if (dim % 64)
+    {
+        uint64* paddedRows = FloodContextRows(ctx, 2*rowsWords);
+        fillRows = paddedRows + rowsWords;
+        for (int y = 0; y < dim; ++y)
+        {
+            for (int w = 0; w < rowWords; ++w)
+            {
+                int numBits = (dim - w*64) < 64 ? (dim - w*64) : 64;
+                paddedRows[y*rowWords + w] = LoadClippedBits(bitdeck, clip, (size_t)y*dim + w*64, numBits);
+            }
+        }
+        PadRows(filled, dim, fillRows);
+        bitRows = paddedRows;
+        clipRows = 0;
+    }
+    
+    int numFilled = 0;
+    int seedWord = seedY*rowWords + seedX/64;
+    uint64 seedBit = 1llu << (seedX%64);
+    uint64 seedOpen = bitRows[seedWord] & (clipRows ? clipRows[seedWord] : ~0llu) & ~fillRows[seedWord];
+    if (seedOpen & seedBit)
+    {
+        fillRows[seedWord] |= seedBit;
+        ++numFilled;
+        
+        int* stack = FloodContextStack(ctx, dim);
+        stack[0] = seedY;
+        if (dim == 64)
+        {
+            numFilled += CarrySpanFillRows(bitRows, clipRows, fillRows, dim, stack, 1, 1llu << seedY, FloodDiagonals(ctx), 0);
+        }
+        else
+        {
+            uint64* stackedRows = FloodContextRowFlags(ctx, rowWords);
+            memset(stackedRows, 0, sizeof(uint64)*rowWords);
+            stackedRows[seedY/64] |= 1llu << (seedY%64);
+            numFilled += SimulSpanFillStack(bitRows, clipRows, fillRows, dim, stack, 1, stackedRows, FloodDiagonals(ctx), 0);
+        }
+    }
+    
+    if (dim % 64) UnpadRows(fillRows, dim, filled);
+    
+    return numFilled;
+}
+
+static int ClippedFillBaseline(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY)
+{
+    return ClippedFill(ctx, bitdeck, clip, dim, filled, seedX, seedY);
+}
+
+TARGET_BMI2 static int ClippedFill_BMI2(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY)
+{
+    return ClippedFill(ctx, bitdeck, clip, dim, filled, seedX, seedY);
+}
+
+TARGET_AVX2 static int ClippedFill256_AVX2(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY)
+{
+    return ClippedSimulSpanFill256(ctx, bitdeck, clip, dim, filled, seedX, seedY, 0);
+}
+
+int Flood_Clipped(FloodContext* ctx, const uint8* bitdeck, const uint8* clip, int dim, uint8* filled, int seedX, int seedY)
+{
+    if ((seedX < 0) | (seedX >= dim) | (seedY < 0) | (seedY >= dim)) return 0;
+    if (!DeckCell(clip, dim, seedX, seedY)) return 0;
+    
+    if (dim == 256 && FloodActiveTier() >= FloodTier_AVX2) return ClippedFill256_AVX2(ctx, bitdeck, clip, dim, filled, seedX, seedY);
+    if (FloodActiveTier() >= FloodTier_BMI2) return ClippedFill_BMI2(ctx, bitdeck, clip, dim, filled, seedX, seedY);
+    return ClippedFillBaseline(ctx, bitdeck, clip, dim, filled, seedX, seedY);
+}